@@ -314,11 +314,12 @@ class Context:
         This follows the Python slice convention.
         """
         shape = _dims2shape(*dims)
-        objs = list()
-        for indices in itertools.product(*[range(i, j) for i, j in shape]):
-            suffix = "[" + ",".join(str(idx) for idx in indices) + "]"
-            objs.append(self.get_var(name + suffix))
-        return array(objs, shape)
+        num = len(shape)
+        starts = ffi.new("size_t []", [start for start, _ in shape])
+        stops = ffi.new("size_t []", [stop for _, stop in shape])
+        cdata = lib.boolexpr_Context_get_vars(
+            self._cdata, name.encode("ascii"), num, starts, stops)
+        return ndarray(Array(cdata), shape)
 
 
 class BoolExpr:
@@ -481,9 +482,20 @@ class BoolExpr:
         1. An ``Atom`` has size one.
         2. An ``Operator`` has size equal to the sum of its arguments' sizes
            plus one.
+
+        Shared sub-expressions count once per reference,
+        so the size saturates at ``2**32 - 1``.
         """
         return lib.boolexpr_BoolExpr_size(self._cdata)
 
+    def dag_size(self):
+        """Return the number of unique nodes in the expression.
+
+        Unlike ``size``, a sub-expression shared by several operators
+        is only counted once.
+        """
+        return lib.boolexpr_BoolExpr_dag_size(self._cdata)
+
     def is_cnf(self):
         """Return ``True`` if the expression is in conjunctive normal form (CNF).
 
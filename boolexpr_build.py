@@ -123,6 +123,8 @@ enum Kind {
 CONTEXT boolexpr_Context_new(void);
 void boolexpr_Context_del(CONTEXT);
 BX boolexpr_Context_get_var(CONTEXT, STRING);
+ARRAY boolexpr_Context_get_vars(CONTEXT, STRING, size_t,
+                                size_t const *, size_t const *);
 
 void boolexpr_String_del(STRING);
 
@@ -217,6 +219,7 @@ uint8_t boolexpr_BoolExpr_kind(BX);
 STRING boolexpr_BoolExpr_to_string(BX);
 uint32_t boolexpr_BoolExpr_depth(BX);
 uint32_t boolexpr_BoolExpr_size(BX);
+uint32_t boolexpr_BoolExpr_dag_size(BX);
 _Bool boolexpr_BoolExpr_is_cnf(BX);
 _Bool boolexpr_BoolExpr_is_dnf(BX);
 BX boolexpr_BoolExpr_simplify(BX);
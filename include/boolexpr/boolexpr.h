@@ -21,12 +21,17 @@
 
 
 #include <boost/optional.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
+#include <boost/version.hpp>
 #include <cryptominisat4/cryptominisat.h>  // SATSolver, lbool
 
+#include <atomic>
+#include <chrono>
 #include <functional>  // function
 #include <initializer_list>
 #include <iterator>
-#include <memory>  // enable_shared_from_this, shared_ptr
+#include <memory>  // shared_ptr
+#include <mutex>
 #include <ostream>
 #include <string>
 #include <unordered_map>
@@ -86,56 +91,263 @@ class Variable;
 class Operator;
 class LatticeOperator;
 class Array;
+class Bdd;
+class Arena;
 
 
 using id_t = uint32_t;
 
-using bx_t = std::shared_ptr<BoolExpr const>;
+using bx_t = boost::intrusive_ptr<BoolExpr const>;
 
-using const_t = std::shared_ptr<Constant const>;
-using zero_t = std::shared_ptr<Zero const>;
-using one_t = std::shared_ptr<One const>;
-using log_t = std::shared_ptr<Logical const>;
-using ill_t = std::shared_ptr<Illogical const>;
+using const_t = boost::intrusive_ptr<Constant const>;
+using zero_t = boost::intrusive_ptr<Zero const>;
+using one_t = boost::intrusive_ptr<One const>;
+using log_t = boost::intrusive_ptr<Logical const>;
+using ill_t = boost::intrusive_ptr<Illogical const>;
 
-using lit_t = std::shared_ptr<Literal const>;
-using var_t = std::shared_ptr<Variable const>;
-using op_t = std::shared_ptr<Operator const>;
-using lop_t = std::shared_ptr<LatticeOperator const>;
+using lit_t = boost::intrusive_ptr<Literal const>;
+using var_t = boost::intrusive_ptr<Variable const>;
+using op_t = boost::intrusive_ptr<Operator const>;
+using lop_t = boost::intrusive_ptr<LatticeOperator const>;
 
 using var2bx_t = std::unordered_map<var_t, bx_t>;
 using var2op_t = std::unordered_map<var_t, op_t>;
 using point_t = std::unordered_map<var_t, const_t>;
 
+/// A point as constants indexed by variable id >> 1.
+/// Null entries are free variables.
+using dense_point_t = std::vector<const_t>;
+
+/// A substitution indexed by variable id >> 1.
+/// Null entries are not substituted.
+using dense_var2bx_t = std::vector<bx_t>;
+
 using soln_t = std::pair<bool, boost::optional<point_t>>;
 
 
+/// A namespace of variables.
+///
+/// A Context may be shared by several threads,
+/// which can create variables and build expressions concurrently.
 class Context
 {
     friend class Complement;
     friend class Variable;
 
-    id_t id;
+    static size_t const NUM_SHARDS = 16;
+    static size_t const NUM_SEGMENTS = 32;
+
+    std::atomic<id_t> id;
+
+    // Variables by name, split into shards with separate locks
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, var_t> vars;
+    };
+
+    Shard shards[NUM_SHARDS];
+
+    // A block of variables made by get_vars
+    struct VarBlock
+    {
+        std::string prefix;
+        std::vector<std::pair<size_t, size_t>> dims;
+        id_t first;
+        size_t size;
+    };
+
+    // Guards blocks, prefix2block, indexed, and formatting block names
+    mutable std::mutex blocks_mutex;
 
-    std::unordered_map<std::string, var_t> vars;
-    std::unordered_map<id_t, std::string> id2name;
-    std::unordered_map<id_t, lit_t> id2lit;
+    std::vector<VarBlock> blocks;
+    std::unordered_map<std::string, size_t> prefix2block;
 
-    std::string get_name(id_t id) const;
-    lit_t get_lit(id_t id) const;
+    // Prefixes of "prefix[...]" names made by get_var
+    std::unordered_set<std::string> indexed;
+
+    // Literal ids are dense, so index by id instead of hashing.
+    // Both tables are split into segments of doubling size.
+    // Segments never move once allocated, so lookups need no lock.
+    // id2name is indexed by id >> 1, id2lit by id.
+    // Names are written before their variable is returned,
+    // and never change after that.
+    // Block variables have no name here.
+    // get_name formats each of their names once, under blocks_mutex,
+    // and publishes it in id2block_name, indexed by id >> 1.
+    std::atomic<std::string *> id2name[NUM_SEGMENTS];
+    std::atomic<lit_t *> id2lit[NUM_SEGMENTS];
+    std::atomic<std::atomic<std::string const *> *> id2block_name[NUM_SEGMENTS];
+
+    std::string const & get_name(id_t id) const;
+    lit_t const & get_lit(id_t id) const;
+
+    var_t add_var(id_t id);
+    var_t get_block_var(std::string const & name) const;
 
 public:
     Context();
+    ~Context();
+
+    Context(Context const &) = delete;
+    Context & operator=(Context const &) = delete;
 
     var_t get_var(std::string name);
+
+    /// Return a block of variables named "prefix[i,j,...]".
+    ///
+    /// Each dimension is a (start, stop) pair,
+    /// following the Python slice convention.
+    /// The variables are returned in row-major order, and have contiguous ids.
+    /// Their names are only formatted when they are needed.
+    std::vector<var_t> get_vars(
+        std::string prefix,
+        std::vector<std::pair<size_t, size_t>> const & dims);
 };
 
 
-class BoolExpr : public std::enable_shared_from_this<BoolExpr>
+/// A pool of memory for operator nodes.
+///
+/// While a NodePoolScope is active, new operator nodes are allocated
+/// from its pool instead of the general-purpose heap.
+/// Destroying the pool releases all of its memory in bulk,
+/// as soon as the last node allocated from it has been freed.
+///
+/// A pool must only be used by one thread.
+class NodePool
 {
+    friend Arena * current_arena();
+
+    Arena * arena;
+
+public:
+    NodePool();
+    ~NodePool();
+
+    NodePool(NodePool const &) = delete;
+    NodePool & operator=(NodePool const &) = delete;
+
+    /// Return the number of live allocations.
+    size_t live() const;
+
+    /// Return the number of bytes reserved from the system.
+    size_t capacity() const;
+};
+
+
+/// Allocate operator nodes from a NodePool for the lifetime of this object.
+class NodePoolScope
+{
+    NodePool * prev;
+
+public:
+    NodePoolScope(NodePool &);
+    ~NodePoolScope();
+
+    NodePoolScope(NodePoolScope const &) = delete;
+    NodePoolScope & operator=(NodePoolScope const &) = delete;
+};
+
+
+/// Argument storage for operator nodes.
+///
+/// Up to INLINE arguments are stored in the node itself,
+/// so small operators do not need a second heap allocation.
+/// Larger operators keep their arguments in one heap array.
+class ArgVec
+{
+public:
+    using value_type = bx_t;
+    using const_iterator = bx_t const *;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static size_t const INLINE = 3;
+
+private:
+    size_t n;
+
+    union {
+        bx_t small[INLINE];
+        bx_t * large;
+    };
+
+public:
+    explicit ArgVec(std::vector<bx_t> const & args);
+    ~ArgVec();
+
+    ArgVec(ArgVec const &) = delete;
+    ArgVec & operator=(ArgVec const &) = delete;
+
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+
+    /// Return true if the arguments are stored inline.
+    bool is_inline() const { return n <= INLINE; }
+
+    bx_t const * data() const { return is_inline() ? small : large; }
+    bx_t const & operator[](size_t i) const { return data()[i]; }
+
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + n; }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    const_reverse_iterator crbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator crend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+};
+
+
+/// Reference counts are atomic by default.
+/// Define BOOLEXPR_SINGLE_THREADED (for the library and all of its users)
+/// to use plain integers when expressions are never shared between threads.
+#ifdef BOOLEXPR_SINGLE_THREADED
+using refcount_t = uint32_t;
+#else
+using refcount_t = std::atomic<uint32_t>;
+#endif
+
+
+class BoolExpr
+{
+    friend class Arena;
+    friend class Reclaimer;
+    friend class UniqueTable;
+    friend void intrusive_ptr_add_ref(BoolExpr const *);
+    friend void intrusive_ptr_release(BoolExpr const *);
     friend bx_t operator~(bx_t const &);
     friend std::ostream& operator<<(std::ostream&, bx_t const &);
 
+    mutable refcount_t refs;
+
+    // Allocated from a NodePool
+    bool pooled;
+
+    // Support variables, computed on demand
+    mutable std::atomic<std::vector<Variable const *> const *> supp;
+
+protected:
+    // Structural hash, set by the constructors
+    uint64_t shash;
+
+private:
+    static void destroy(BoolExpr const *);
+
+    // Free a node, and the nodes it held the last reference to,
+    // using a worklist instead of recursion.
+    // If pooled is not null, pooled nodes go onto it instead of being freed.
+    static void free_all(BoolExpr const *,
+                         std::vector<BoolExpr const *> * pooled = nullptr);
+
+    // Add a reference, unless the node is already being destroyed
+    bool try_add_ref() const;
+
 protected:
     virtual bx_t invert() const = 0;
     virtual std::ostream& op_lsh(std::ostream&) const = 0;
@@ -165,13 +377,48 @@ public:
 
     Kind const kind;
 
+    /// Creation order of this node, unique within a process.
+    /// Simplified operators keep their arguments sorted by this number.
+    uint64_t const serial;
+
     BoolExpr(Kind kind);
+    virtual ~BoolExpr();
+
+    BoolExpr(BoolExpr const &) = delete;
+    BoolExpr & operator=(BoolExpr const &) = delete;
+
+    /// Return a new reference to this expression.
+    bx_t shared_from_this() const { return bx_t(this); }
 
     std::string to_string() const;
 
+    /// Return the number of operators on the longest path to an atom.
     virtual uint32_t depth() const = 0;
+
+    /// Return the number of nodes in the expression, counted as a tree,
+    /// so a shared sub-expression counts once per reference.
+    /// That grows exponentially with sharing,
+    /// so the result saturates at UINT32_MAX.
     virtual uint32_t size() const = 0;
 
+    /// Return the number of unique nodes in the expression DAG.
+    uint32_t dag_size() const;
+
+    /// Return a 64-bit hash of the expression structure.
+    ///
+    /// It depends on the kinds, the argument order, and the literal ids,
+    /// but not on node addresses, so it is the same run to run.
+    uint64_t structural_hash() const { return shash; }
+
+    /// Return true if both expressions have the same structure.
+    ///
+    /// Unequal hashes reject in constant time.
+    /// Otherwise both DAGs are compared, visiting each pair of nodes once.
+    /// Literals from different Contexts match by name and polarity.
+    /// The hash includes the variable id, so their variables must also
+    /// have been made in the same order.
+    bool equals_structurally(bx_t const &) const;
+
     virtual bool is_cnf() const = 0;
     virtual bool is_dnf() const = 0;
 
@@ -184,8 +431,29 @@ public:
     virtual bx_t tseytin(Context&, std::string const & = "a") const = 0;
 
     virtual bx_t compose(var2bx_t const &) const = 0;
+
+    /// Substitute the variables of one context from a dense table,
+    /// all at once, and optionally simplify each rebuilt operator.
+    /// Each unique node is visited once, so shared sub-expressions,
+    /// and the substituted functions, stay shared in the result.
+    bx_t compose_dense(Context const *, dense_var2bx_t const &,
+                       bool simplify = false) const;
     virtual bx_t restrict_(point_t const &) const = 0;
 
+    /// Restrict the variables of one context to a dense point.
+    /// Variables of other contexts are left free.
+    bx_t restrict_dense(Context const *, dense_point_t const &) const;
+
+    /// Evaluate at a point, without creating any nodes.
+    /// Free variables are X.
+    /// As in simplify, an illogical argument wins over an argument that
+    /// decides the value, so every argument is evaluated.
+    const_t eval(point_t const &) const;
+
+    /// Evaluate with the variables of one context set to bits[id >> 1].
+    /// Variables of other contexts, or past the end of bits, are X.
+    const_t eval(Context const *, std::vector<bool> const &) const;
+
     soln_t sat() const;
 
     bx_t to_nnf() const;
@@ -194,6 +462,12 @@ public:
     std::unordered_set<var_t> support() const;
     uint32_t degree() const;
 
+    /// Return the support variables, sorted by id.
+    ///
+    /// The result is computed once, then cached on the node.
+    /// The pointers are valid for as long as this expression is.
+    std::vector<Variable const *> const & support_vars() const;
+
     bx_t expand(std::vector<var_t> const &) const;
 
     bx_t smoothing(std::vector<var_t> const &) const;
@@ -202,6 +476,51 @@ public:
 };
 
 
+inline void
+intrusive_ptr_add_ref(BoolExpr const * bx)
+{
+#ifdef BOOLEXPR_SINGLE_THREADED
+    ++bx->refs;
+#else
+    bx->refs.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+
+inline void
+intrusive_ptr_release(BoolExpr const * bx)
+{
+#ifdef BOOLEXPR_SINGLE_THREADED
+    if (--bx->refs == 0) {
+#else
+    if (bx->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+#endif
+        BoolExpr::destroy(bx);
+    }
+}
+
+
+inline bool
+BoolExpr::try_add_ref() const
+{
+#ifdef BOOLEXPR_SINGLE_THREADED
+    if (refs == 0) {
+        return false;
+    }
+    ++refs;
+    return true;
+#else
+    auto n = refs.load(std::memory_order_relaxed);
+    while (n != 0) {
+        if (refs.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+
+
 class Atom : public BoolExpr
 {
 public:
@@ -351,6 +670,21 @@ public:
 
 class Operator : public BoolExpr
 {
+    // Arguments never change, so these are counted when the node is made
+    uint32_t _depth;
+    uint32_t _size;
+    bool _has_ill;
+
+    // Set depth, size, illogical bit, and structural hash from the arguments
+    void summarize_args();
+
+    // Owns a reference to the result of simplify,
+    // unless that result is this node.
+    mutable std::atomic<BoolExpr const *> simplified;
+
+    // Simplify non-simple descendants bottom-up, without recursion
+    void _simplify_descendants() const;
+
     var_t to_con1(Context&, std::string const &, uint32_t&, var2op_t&) const;
     op_t  to_con2(Context&, std::string const &, uint32_t&, var2op_t&) const;
 
@@ -363,21 +697,28 @@ protected:
     virtual bx_t eqvar(var_t const &) const = 0;
     virtual op_t from_args(std::vector<bx_t> const &&) const = 0;
 
-    op_t transform(std::function<bx_t(bx_t const &)>) const;
-
 public:
     bool const simple;
-    std::vector<bx_t> const args;
+    ArgVec const args;
 
     Operator(Kind kind, bool simple, std::vector<bx_t> const & args);
     Operator(Kind kind, bool simple, std::vector<bx_t> const && args);
+    ~Operator();
 
     uint32_t depth() const;
     uint32_t size() const;
 
+    /// Return true if an illogical constant appears under this operator.
+    bool has_ill() const;
+
     bool is_cnf() const;
     bool is_dnf() const;
     bx_t simplify() const;
+    bx_t to_binop() const;
+    bx_t to_cnf() const;
+    bx_t to_dnf() const;
+    bx_t to_latop() const;
+    bx_t to_posop() const;
     bx_t tseytin(Context&, std::string const & = "a") const;
     bx_t compose(var2bx_t const &) const;
     bx_t restrict_(point_t const &) const;
@@ -390,8 +731,6 @@ class LatticeOperator : public Operator
 {
 public:
     LatticeOperator(Kind kind, bool simple, std::vector<bx_t> const & args);
-
-    bx_t to_latop() const;
 };
 
 
@@ -407,12 +746,6 @@ protected:
 
 public:
     Nor(bool simple, std::vector<bx_t> const & args);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -435,10 +768,6 @@ public:
 
     bool is_cnf() const;
     bool is_dnf() const;
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_posop() const;
 };
 
 
@@ -454,12 +783,6 @@ protected:
 
 public:
     Nand(bool simple, std::vector<bx_t> const & args);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -482,10 +805,6 @@ public:
 
     bool is_cnf() const;
     bool is_dnf() const;
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_posop() const;
 };
 
 
@@ -501,12 +820,6 @@ protected:
 
 public:
     Xnor(bool simple, std::vector<bx_t> const & args);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -525,12 +838,6 @@ public:
     Xor(bool simple, std::vector<bx_t> const && args);
 
     static bx_t identity();
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -546,12 +853,6 @@ protected:
 
 public:
     Unequal(bool simple, std::vector<bx_t> const & args);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -568,12 +869,6 @@ protected:
 public:
     Equal(bool simple, std::vector<bx_t> const & args) : Operator(EQ, simple, args) {}
     Equal(bool simple, std::vector<bx_t> const && args) : Operator(EQ, simple, args) {}
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -589,12 +884,6 @@ protected:
 
 public:
     NotImplies(bool simple, bx_t p, bx_t q);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -610,12 +899,6 @@ protected:
 
 public:
     Implies(bool simple, bx_t p, bx_t q);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -631,12 +914,6 @@ protected:
 
 public:
     NotIfThenElse(bool simple, bx_t s, bx_t d1, bx_t d0);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -652,12 +929,6 @@ protected:
 
 public:
     IfThenElse(bool simple, bx_t s, bx_t d1, bx_t d0);
-
-    bx_t to_binop() const;
-    bx_t to_cnf() const;
-    bx_t to_dnf() const;
-    bx_t to_latop() const;
-    bx_t to_posop() const;
 };
 
 
@@ -706,6 +977,336 @@ public:
 };
 
 
+/// A straight-line program that evaluates one or more expressions.
+///
+/// Compiling linearizes the DAG into instructions in topological order.
+/// Each instruction reads operand slots written by earlier instructions,
+/// and writes one output slot,
+/// so evaluation is one pass over flat arrays.
+class Tape
+{
+public:
+    struct Instr {
+        // Or, And, Xor, Equal, Implies, or IfThenElse
+        BoolExpr::Kind kind;
+        // Invert the result
+        bool neg;
+        // Operands are operands[first] ... operands[first+n-1]
+        uint32_t first;
+        uint32_t n;
+        uint32_t out;
+    };
+
+private:
+    // Input i is in slot i
+    std::vector<var_t> inputs;
+
+    // Initial slot values, which hold the constants
+    std::vector<BoolExpr::Kind> init;
+
+    std::vector<Instr> instrs;
+
+    // Operands and outputs are (slot << 1) | neg
+    std::vector<uint32_t> operands;
+    std::vector<uint32_t> outputs;
+
+    void compile(std::vector<bx_t> const &);
+    void run(std::vector<BoolExpr::Kind> & slots) const;
+
+public:
+    Tape(bx_t const &);
+    Tape(Array const &);
+
+    /// Return the input variables, sorted by id.
+    std::vector<var_t> const & get_inputs() const;
+
+    size_t num_instrs() const;
+    size_t num_outputs() const;
+
+    /// Evaluate at one point, where bits[i] is the value of input i.
+    /// Inputs past the end of bits are logical, and extra bits are ignored.
+    /// Return zero, one, logical, or illogical for each output.
+    std::vector<const_t> eval(std::vector<bool> const & bits) const;
+
+    /// Evaluate a batch of points.
+    std::vector<std::vector<const_t>>
+    eval_batch(std::vector<std::vector<bool>> const & points) const;
+
+    /// Simulate many patterns at once, 64 per word.
+    /// words[i] holds the packed values of input i,
+    /// with pattern k in bit k % 64 of word k / 64.
+    /// Return the packed values of each output in the same layout.
+    /// width is the number of patterns per pass: 64, 256 (AVX2),
+    /// or 512 (AVX-512). It is capped to what the CPU supports,
+    /// and 0 picks the widest one.
+    /// Logical and illogical constants simulate as zero.
+    std::vector<std::vector<uint64_t>>
+    simulate(std::vector<std::vector<uint64_t>> const & words,
+             size_t width = 0) const;
+
+    /// Simulate many patterns at once with unknowns,
+    /// using two rails per value, in the same layout as simulate.
+    /// ones[i] marks the patterns where input i may be one,
+    /// and zeros[i] the patterns where it may be zero.
+    /// So zero is (0, 1), one is (1, 0), logical is (1, 1),
+    /// and illogical is (0, 0).
+    /// Return the (ones, zeros) rails of each output,
+    /// which propagate logical and illogical the same way as simplify.
+    std::pair<std::vector<std::vector<uint64_t>>,
+              std::vector<std::vector<uint64_t>>>
+    simulate_ternary(std::vector<std::vector<uint64_t>> const & ones,
+                     std::vector<std::vector<uint64_t>> const & zeros,
+                     size_t width = 0) const;
+};
+
+
+/// A truth table of a function of at most 16 variables.
+///
+/// Bit k of the table is the value at the point where
+/// variable i has the value of bit i of k.
+/// Tables of fewer than six variables repeat to fill one word,
+/// so most operations are a few word-wide instructions.
+class TruthTable
+{
+    // Sorted by id
+    std::vector<var_t> vars;
+    std::vector<uint64_t> words;
+
+    size_t index(var_t const &) const;
+
+    TruthTable cofactors(std::vector<var_t> const &, BoolExpr::Kind) const;
+
+public:
+    TruthTable(std::vector<var_t> const & vars,
+               std::vector<uint64_t> const & words);
+
+    std::vector<var_t> const & get_vars() const;
+    std::vector<uint64_t> const & get_words() const;
+
+    bool is_zero() const;
+    bool is_one() const;
+
+    /// Return the number of points where the function is one.
+    uint64_t count() const;
+
+    /// Return true if both tables have the same function.
+    /// Both must have the same variables.
+    bool equiv(TruthTable const &) const;
+
+    TruthTable operator~() const;
+    TruthTable operator|(TruthTable const &) const;
+    TruthTable operator&(TruthTable const &) const;
+    TruthTable operator^(TruthTable const &) const;
+
+    /// Return the cofactor with x set to value.
+    /// It keeps x, but no longer depends on it.
+    TruthTable cofactor(var_t const & x, bool value) const;
+
+    TruthTable smoothing(std::vector<var_t> const &) const;
+    TruthTable consensus(std::vector<var_t> const &) const;
+    TruthTable derivative(std::vector<var_t> const &) const;
+
+    soln_t sat() const;
+
+    /// Convert to an expression, by Shannon expansion.
+    bx_t to_bx() const;
+};
+
+
+/// A manager of reduced, ordered binary decision diagrams.
+///
+/// Nodes are hash-consed in one unique table per variable,
+/// and only else edges may be complemented,
+/// so two BDDs are equivalent iff they are the same edge.
+/// Results of ITE, cofactor, and quantification go in a computed cache.
+/// Nodes that no Bdd reaches are garbage collected.
+///
+/// Variables can be reordered in place, by sifting or window permutation,
+/// either on request or as the node count grows.
+/// Every Bdd keeps its function across a reordering.
+///
+/// A manager and its BDDs belong to one thread at a time,
+/// and the manager must outlive its BDDs.
+class BddManager
+{
+    friend class Bdd;
+
+    static uint32_t const FREE = 0xFFFFFFFF;
+
+    struct Node {
+        // Variable index, or FREE
+        uint32_t var;
+        // Edges are (node << 1) | complement
+        uint32_t hi;
+        uint32_t lo;
+        // Next node in the same unique table bucket
+        uint32_t next;
+        // References from parents and from Bdd handles
+        uint32_t refs;
+    };
+
+    struct Entry {
+        uint32_t op;
+        uint32_t f;
+        uint32_t g;
+        uint32_t h;
+        uint32_t r;
+    };
+
+    // Node 0 is the terminal one
+    std::vector<Node> nodes;
+    std::vector<uint32_t> free_nodes;
+
+    // Collect when there are more nodes than this
+    size_t gc_limit;
+
+    std::vector<var_t> vars;
+    std::unordered_map<var_t, uint32_t> var2index;
+    std::vector<uint32_t> var2level;
+    std::vector<uint32_t> level2var;
+
+    // One unique table per variable index, chained through Node::next
+    std::vector<std::vector<uint32_t>> buckets;
+    std::vector<size_t> counts;
+
+    std::vector<Entry> cache;
+
+    bool auto_reorder;
+    // Reorder when there are more nodes than this
+    size_t reorder_limit;
+    double reorder_time;
+    std::chrono::steady_clock::time_point deadline;
+
+    void ref(uint32_t edge);
+    void deref(uint32_t edge);
+    uint32_t level(uint32_t edge) const;
+    uint32_t index(var_t const &);
+    uint32_t cube(std::vector<var_t> const &, bool & missing);
+    void insert(uint32_t n);
+    void remove(uint32_t n);
+    void resize(uint32_t index);
+    void sweep(std::vector<uint32_t> & stack);
+    void maybe_gc();
+
+    void swap(uint32_t level);
+    bool expired() const;
+    void sift(uint32_t index);
+    size_t window(uint32_t level);
+
+    uint32_t make(uint32_t index, uint32_t hi, uint32_t lo);
+    uint32_t ite(uint32_t f, uint32_t g, uint32_t h);
+    uint32_t cofactor(uint32_t f, uint32_t index, bool value);
+    uint32_t quantify(uint32_t f, uint32_t cube, BoolExpr::Kind kind);
+    uint32_t convert(bx_t const &, std::vector<uint32_t> const &);
+
+public:
+    BddManager();
+
+    size_t num_vars() const;
+
+    /// Return the number of internal nodes,
+    /// including unreferenced ones that gc has not freed yet.
+    size_t num_nodes() const;
+
+    /// Free every node that no Bdd reaches.
+    /// This also happens on its own as nodes pile up.
+    void gc();
+
+    Bdd zero();
+    Bdd one();
+
+    /// Return the BDD of x.
+    /// New variables go below every existing one in the order.
+    Bdd var(var_t const & x);
+
+    /// Convert an expression.
+    /// Return none if it contains a logical or illogical constant.
+    boost::optional<Bdd> to_bdd(bx_t const & f);
+
+    /// Convert a BDD to an expression, by Shannon expansion.
+    bx_t from_bdd(Bdd const & f);
+
+    Bdd ite(Bdd const & f, Bdd const & g, Bdd const & h);
+
+    /// Return the variables in order, from top to bottom.
+    std::vector<var_t> get_order() const;
+
+    /// Reorder by Rudell's sifting: move each variable, largest first,
+    /// to the level where the BDDs are smallest.
+    /// Return the number of nodes.
+    size_t reorder_sift();
+
+    /// Reorder by trying every permutation of each three adjacent levels,
+    /// until that stops helping.
+    /// Return the number of nodes.
+    size_t reorder_window();
+
+    /// Enable or disable sifting as the node count grows,
+    /// and return its previous state.
+    /// Automatic reordering is off by default,
+    /// so a manager keeps the order it was given unless asked.
+    /// It sifts whenever the node count doubles;
+    /// pair it with set_reorder_time_limit to bound each pause.
+    bool enable_auto_reorder(bool enable = true);
+
+    /// Limit each reordering to this many seconds, or none if zero.
+    /// A reordering that runs out of time keeps the best order so far.
+    /// The default is zero, so an explicit reorder_sift or reorder_window
+    /// always runs to completion and gives the same order on every run.
+    void set_reorder_time_limit(double seconds);
+};
+
+
+/// A reference to a function in a BddManager.
+class Bdd
+{
+    friend class BddManager;
+
+    BddManager * mgr;
+    uint32_t edge;
+
+    Bdd(BddManager * mgr, uint32_t edge);
+
+public:
+    Bdd(Bdd const &);
+    ~Bdd();
+
+    Bdd & operator=(Bdd const &);
+
+    /// Return true if both BDDs are the same function.
+    bool operator==(Bdd const &) const;
+    bool operator!=(Bdd const &) const;
+
+    bool is_zero() const;
+    bool is_one() const;
+
+    Bdd operator~() const;
+    Bdd operator|(Bdd const &) const;
+    Bdd operator&(Bdd const &) const;
+    Bdd operator^(Bdd const &) const;
+
+    /// Return the cofactor with x set to value.
+    Bdd cofactor(var_t const & x, bool value) const;
+
+    Bdd smoothing(std::vector<var_t> const &) const;
+    Bdd consensus(std::vector<var_t> const &) const;
+    Bdd derivative(std::vector<var_t> const &) const;
+
+    /// Return the number of points over the support where it is one.
+    /// It is exact up to 2^53.
+    double count() const;
+
+    /// Return the number of nodes, including the terminal.
+    size_t size() const;
+
+    /// Return the support variables, sorted by id.
+    std::vector<var_t> support() const;
+
+    /// Return a satisfying point of the variables on one path.
+    soln_t sat() const;
+};
+
+
 class dfs_iter : public std::iterator<std::input_iterator_tag, bx_t>
 {
     enum class Color { WHITE, GRAY, BLACK };
@@ -730,7 +1331,8 @@ public:
 
 class sat_iter : public std::iterator<std::input_iterator_tag, point_t>
 {
-    Context ctx;
+    // Shared by copies, b/c the auxiliary variables refer to it
+    std::shared_ptr<Context> ctx;
     std::unordered_map<uint32_t, var_t> idx2var;
 
     CMSat::SATSolver solver;
@@ -809,7 +1411,6 @@ public:
 
 class domain_iter : public std::iterator<std::input_iterator_tag, point_t>
 {
-    std::unordered_set<var_t> s;
     points_iter it;
 
 public:
@@ -826,9 +1427,16 @@ public:
 class cf_iter : public std::iterator<std::input_iterator_tag, bx_t>
 {
     bx_t f;
-    points_iter it;
+    std::vector<var_t> vars;
+    space_iter it;
     bx_t cf;
 
+    // Shared by all vars, or nullptr
+    Context const * ctx;
+    dense_point_t point;
+
+    void restrict_();
+
 public:
     cf_iter();
     cf_iter(bx_t const &, std::vector<var_t> const &);
@@ -851,6 +1459,56 @@ log_t logical();
 
 ill_t illogical();
 
+/// Return true if operator nodes are hash-consed by the global unique table.
+bool unique_table_enabled();
+
+/// Enable or disable the global unique table, and return its previous state.
+/// While enabled, structurally equal operators are pointer equal.
+bool enable_unique_table(bool enable = true);
+
+/// Return the number of operator nodes in the global unique table.
+size_t unique_table_size();
+
+/// Return true if commutative operators sort their arguments.
+bool canonical_order_enabled();
+
+/// Enable or disable canonical argument order, and return its previous state.
+/// While enabled, Nor, Or, Nand, And, Xnor, Xor, Unequal, and Equal
+/// sort their arguments by structural hash when they are made,
+/// breaking ties by node serial number.
+/// Structurally equal arguments therefore sort the same way
+/// regardless of the order in which they were created.
+/// With the unique table, or_({a, b}) and or_({b, a}) are then the same node.
+bool enable_canonical_order(bool enable = true);
+
+/// Return true if unreferenced nodes are freed on a background thread.
+bool background_destroy_enabled();
+
+/// Enable or disable freeing nodes on a background thread,
+/// and return its previous state.
+/// Either way, a node's arguments are freed from a worklist, not recursively,
+/// so dropping a very deep expression cannot overflow the stack.
+/// Dropping the last reference to a pooled node frees it on the calling thread.
+/// Pooled nodes that the background thread finds under an unpooled node
+/// are handed back to the thread that dropped it,
+/// which frees them the next time it drops a node or waits.
+bool enable_background_destroy(bool enable = true);
+
+/// Block until the background thread has freed every node given to it,
+/// then free the pooled nodes it handed back to the calling thread.
+void wait_background_destroy();
+
+/// Return the truth table of f over its support.
+/// Return none if f has more than 16 variables,
+/// or if it is logical or illogical at any point.
+boost::optional<TruthTable> truth_table(bx_t const & f);
+
+/// Return the truth table of f over the variables xs.
+/// Return none if xs does not include its support,
+/// or for the same reasons as above.
+boost::optional<TruthTable> truth_table(bx_t const & f,
+                                        std::vector<var_t> const & xs);
+
 bx_t nor(std::vector<bx_t> const &);
 bx_t nor(std::vector<bx_t> const &&);
 bx_t nor(std::initializer_list<bx_t> const);
@@ -936,6 +1594,28 @@ Array * operator*(size_t, Array const &);
 } // namespace boolexpr
 
 
+// Boost 1.74 and later provide this specialization
+#if BOOST_VERSION < 107400
+
+namespace std {
+
+
+// Hash expressions by node address, like std::shared_ptr
+template <typename T>
+struct hash<boost::intrusive_ptr<T>>
+{
+    size_t operator()(boost::intrusive_ptr<T> const & p) const
+    {
+        return hash<T *>()(p.get());
+    }
+};
+
+
+} // namespace std
+
+#endif // BOOST_VERSION
+
+
 #endif // __cplusplus
 
 
@@ -966,6 +1646,8 @@ typedef void * const CF_ITER;
 CONTEXT boolexpr_Context_new(void);
 void boolexpr_Context_del(CONTEXT);
 BX boolexpr_Context_get_var(CONTEXT, STRING);
+ARRAY boolexpr_Context_get_vars(CONTEXT, STRING, size_t,
+                                size_t const *, size_t const *);
 
 void boolexpr_String_del(STRING);
 
@@ -1059,6 +1741,7 @@ uint8_t boolexpr_BoolExpr_kind(BX);
 STRING boolexpr_BoolExpr_to_string(BX);
 uint32_t boolexpr_BoolExpr_depth(BX);
 uint32_t boolexpr_BoolExpr_size(BX);
+uint32_t boolexpr_BoolExpr_dag_size(BX);
 bool boolexpr_BoolExpr_is_cnf(BX);
 bool boolexpr_BoolExpr_is_dnf(BX);
 BX boolexpr_BoolExpr_simplify(BX);
@@ -13,19 +13,108 @@
 // limitations under the License.
 
 
+#include <algorithm>
+
 #include "boolexpr/boolexpr.h"
 #include "argset.h"
+#include "unique.h"
 
 
-using std::make_shared;
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::vector;
 
 
 namespace boolexpr {
 
 
-LatticeArgSet::LatticeArgSet(vector<bx_t> const & args,
+// Simplify the arguments, and visit them in serial order,
+// so most insertions land at the end of the vector.
+static vector<bx_t>
+_simplify_args(ArgVec const & args)
+{
+    vector<bx_t> xs;
+    xs.reserve(args.size());
+    for (bx_t const & arg : args) {
+        xs.push_back(arg->simplify());
+    }
+    std::sort(xs.begin(), xs.end(), serial_lt);
+    return xs;
+}
+
+
+// Merge the sorted range [first, last) into the sorted vector xs,
+// dropping duplicates.
+// Gallop to each insertion point, so a short range merges into a long
+// vector in O(m log n) comparisons.
+static void
+_merge(vector<bx_t> & xs, bx_t const * first, bx_t const * last)
+{
+    vector<bx_t> ys;
+    ys.reserve(xs.size() + (last - first));
+
+    size_t i = 0;
+    for (; first != last; ++first) {
+        size_t lo = i;
+        size_t hi = i;
+        for (size_t step = 1; hi < xs.size() && serial_lt(xs[hi], *first);
+                step <<= 1) {
+            lo = hi + 1;
+            hi = i + step;
+        }
+        hi = std::min(hi, xs.size());
+
+        auto pos = std::lower_bound(xs.begin() + lo, xs.begin() + hi,
+                                    *first, serial_lt);
+        for (; xs.begin() + i != pos; ++i) {
+            ys.push_back(std::move(xs[i]));
+        }
+
+        if (i == xs.size() || xs[i] != *first) {
+            ys.push_back(*first);
+        }
+    }
+
+    for (; i < xs.size(); ++i) {
+        ys.push_back(std::move(xs[i]));
+    }
+
+    xs.swap(ys);
+}
+
+
+bool
+ArgSet::contains(bx_t const & arg) const
+{
+    return std::binary_search(args.cbegin(), args.cend(), arg, serial_lt);
+}
+
+
+void
+ArgSet::add(bx_t const & arg)
+{
+    if (args.empty() || serial_lt(args.back(), arg)) {
+        args.push_back(arg);
+        return;
+    }
+
+    auto pos = std::lower_bound(args.begin(), args.end(), arg, serial_lt);
+    if (*pos != arg) {
+        args.insert(pos, arg);
+    }
+}
+
+
+void
+ArgSet::remove(bx_t const & arg)
+{
+    auto pos = std::lower_bound(args.begin(), args.end(), arg, serial_lt);
+    if (pos != args.end() && *pos == arg) {
+        args.erase(pos);
+    }
+}
+
+
+LatticeArgSet::LatticeArgSet(ArgVec const & args,
                              BoolExpr::Kind const & kind,
                              bx_t const & identity,
                              bx_t const & dominator)
@@ -34,8 +123,8 @@ LatticeArgSet::LatticeArgSet(vector<bx_t> const & args,
     , identity {identity}
     , dominator {dominator}
 {
-    for (bx_t const & arg : args) {
-        insert(arg->simplify());
+    for (bx_t const & arg : _simplify_args(args)) {
+        insert(arg);
     }
 }
 
@@ -49,20 +138,17 @@ LatticeArgSet::insert(bx_t const & arg)
                 state = State::isill;
             }
             else if (ARE_SAME(arg, dominator)
-                         || (IS_LIT(arg) && (args.find(~arg) != args.cend()))) {
+                         || (IS_LIT(arg) && contains(~arg))) {
                 state = State::supremum;
             }
             else if (IS_LOG(arg)) {
                 state = State::islog;
             }
             else if (arg->kind == kind) {
-                auto op = static_pointer_cast<Operator const>(arg);
-                for (bx_t const & _arg : op->args) {
-                    insert(_arg);
-                }
+                flatten(static_cast<Operator const *>(arg.get()));
             }
             else if (!ARE_SAME(arg, identity)) {
-                args.insert(arg);
+                add(arg);
                 state = State::basic;
             }
             break;
@@ -72,20 +158,17 @@ LatticeArgSet::insert(bx_t const & arg)
                 state = State::isill;
             }
             else if (ARE_SAME(arg, dominator)
-                         || (IS_LIT(arg) && (args.find(~arg) != args.cend()))) {
+                         || (IS_LIT(arg) && contains(~arg))) {
                 state = State::supremum;
             }
             else if (IS_LOG(arg)) {
                 state = State::islog;
             }
             else if (arg->kind == kind) {
-                auto op = static_pointer_cast<Operator const>(arg);
-                for (bx_t const & _arg : op->args) {
-                    insert(_arg);
-                }
+                flatten(static_cast<Operator const *>(arg.get()));
             }
             else if (!ARE_SAME(arg, identity)) {
-                args.insert(arg);
+                add(arg);
             }
             break;
 
@@ -94,17 +177,14 @@ LatticeArgSet::insert(bx_t const & arg)
                 state = State::isill;
             }
             else if (ARE_SAME(arg, dominator)
-                         || (IS_LIT(arg) && (args.find(~arg) != args.cend()))) {
+                         || (IS_LIT(arg) && contains(~arg))) {
                 state = State::supremum;
             }
             else if (arg->kind == kind) {
-                auto op = static_pointer_cast<Operator const>(arg);
-                for (bx_t const & _arg : op->args) {
-                    insert(_arg);
-                }
+                flatten(static_cast<Operator const *>(arg.get()));
             }
             else if (!ARE_SAME(arg, identity)) {
-                args.insert(arg);
+                add(arg);
             }
             break;
 
@@ -113,10 +193,7 @@ LatticeArgSet::insert(bx_t const & arg)
                 state = State::isill;
             }
             else if (arg->kind == kind) {
-                auto op = static_pointer_cast<Operator const>(arg);
-                for (bx_t const & _arg : op->args) {
-                    insert(_arg);
-                }
+                flatten(static_cast<Operator const *>(arg.get()));
             }
             break;
 
@@ -126,6 +203,41 @@ LatticeArgSet::insert(bx_t const & arg)
 }
 
 
+// Flatten a nested operator of the same kind.
+// A simple one has reduced, sorted arguments, so merge them in one pass.
+void
+LatticeArgSet::flatten(Operator const * op)
+{
+    auto first = op->args.data();
+    auto last = first + op->args.size();
+
+    if (!op->simple || !std::is_sorted(first, last, serial_lt)) {
+        for (bx_t const & arg : op->args) {
+            insert(arg);
+        }
+        return;
+    }
+
+    // Only an illogical argument could change this state
+    if (state == State::supremum) {
+        return;
+    }
+
+    for (auto it = first; it != last; ++it) {
+        if (IS_LIT(*it) && contains(~*it)) {
+            state = State::supremum;
+            return;
+        }
+    }
+
+    _merge(args, first, last);
+
+    if (state == State::infimum) {
+        state = State::basic;
+    }
+}
+
+
 bx_t
 LatticeArgSet::reduce() const
 {
@@ -153,7 +265,7 @@ LatticeArgSet::reduce() const
 }
 
 
-OrArgSet::OrArgSet(vector<bx_t> const & args)
+OrArgSet::OrArgSet(ArgVec const & args)
     : LatticeArgSet(args, BoolExpr::OR, Or::identity(), Or::dominator())
 {}
 
@@ -161,11 +273,11 @@ OrArgSet::OrArgSet(vector<bx_t> const & args)
 bx_t
 OrArgSet::to_op() const
 {
-    return make_shared<Or>(true, vector<bx_t>(args.cbegin(), args.cend()));
+    return make_op(BoolExpr::OR, true, args);
 }
 
 
-AndArgSet::AndArgSet(vector<bx_t> const & args)
+AndArgSet::AndArgSet(ArgVec const & args)
     : LatticeArgSet(args, BoolExpr::AND, And::identity(), And::dominator())
 {}
 
@@ -173,23 +285,64 @@ AndArgSet::AndArgSet(vector<bx_t> const & args)
 bx_t
 AndArgSet::to_op() const
 {
-    return make_shared<And>(true, vector<bx_t>(args.cbegin(), args.cend()));
+    return make_op(BoolExpr::AND, true, args);
 }
 
 
-XorArgSet::XorArgSet(vector<bx_t> const & args)
+XorArgSet::XorArgSet(ArgVec const & args)
     : state {State::basic}
     , parity {true}
 {
-    for (bx_t const & arg : args) {
-        insert(arg->simplify());
+    for (bx_t const & arg : _simplify_args(args)) {
+        insert(arg);
+    }
+}
+
+
+// Return the argument with the same structure as arg, or nullptr
+bx_t
+XorArgSet::find_equal(bx_t const & arg) const
+{
+    auto h = arg->structural_hash();
+    if (hashes.count(h) == 0) {
+        return nullptr;
     }
+
+    if (contains(arg)) {
+        return arg;
+    }
+
+    for (bx_t const & x : args) {
+        if (x->structural_hash() == h && x->equals_structurally(arg)) {
+            return x;
+        }
+    }
+
+    return nullptr;
+}
+
+
+void
+XorArgSet::add_arg(bx_t const & arg)
+{
+    add(arg);
+    hashes.insert(arg->structural_hash());
+}
+
+
+void
+XorArgSet::remove_arg(bx_t const & arg)
+{
+    remove(arg);
+    hashes.erase(hashes.find(arg->structural_hash()));
 }
 
 
 void
 XorArgSet::insert(bx_t const & arg)
 {
+    bx_t dup;
+
     switch (state) {
         case State::basic:
             if (IS_ILL(arg)) {
@@ -202,12 +355,12 @@ XorArgSet::insert(bx_t const & arg)
                 parity ^= static_cast<bool>(arg->kind);
             }
             // xor(x, y, z, z) <=> xor(x, y) ; xnor(x, y, z, z) <=> xnor(x, y)
-            else if (args.find(arg) != args.cend()) {
-                args.erase(arg);
+            else if ((dup = find_equal(arg)) != nullptr) {
+                remove_arg(dup);
             }
             // xor(x, y, z, ~z) <=> xnor(x, y) ; xnor(x, y, z, ~z) <=> xor(x, y)
-            else if (IS_LIT(arg) && args.find(~arg) != args.cend()) {
-                args.erase(~arg);
+            else if (IS_LIT(arg) && contains(~arg)) {
+                remove_arg(~arg);
                 parity ^= true;
             }
             //  xor(x, xor(y, z)) <=>  xor(x, y, z)
@@ -228,7 +381,7 @@ XorArgSet::insert(bx_t const & arg)
                 parity ^= true;
             }
             else {
-                args.insert(arg);
+                add_arg(arg);
             }
             break;
 
@@ -247,7 +400,7 @@ XorArgSet::insert(bx_t const & arg)
 bx_t
 XorArgSet::to_op() const
 {
-    return make_shared<Xor>(true, vector<bx_t>(args.cbegin(), args.cend()));
+    return make_op(BoolExpr::XOR, true, args);
 }
 
 
@@ -278,13 +431,13 @@ XorArgSet::reduce() const
 }
 
 
-EqArgSet::EqArgSet(vector<bx_t> const & args)
+EqArgSet::EqArgSet(ArgVec const & args)
     : state {State::basic}
     , has_zero {false}
     , has_one {false}
 {
-    for (bx_t const & arg : args) {
-        insert(arg->simplify());
+    for (bx_t const & arg : _simplify_args(args)) {
+        insert(arg);
     }
 }
 
@@ -312,13 +465,13 @@ EqArgSet::insert(bx_t const & arg)
                     args.clear();
                 }
             }
-            else if (IS_LIT(arg) && (args.find(~arg) != args.cend())) {
+            else if (IS_LIT(arg) && contains(~arg)) {
                 has_zero = true;
                 has_one = true;
                 args.clear();
             }
             else {
-                args.insert(arg);
+                add(arg);
             }
             break;
 
@@ -337,7 +490,7 @@ EqArgSet::insert(bx_t const & arg)
 bx_t
 EqArgSet::to_op() const
 {
-    return make_shared<Equal>(true, vector<bx_t>(args.cbegin(), args.cend()));
+    return make_op(BoolExpr::EQ, true, args);
 }
 
 
@@ -365,12 +518,12 @@ EqArgSet::reduce() const
 
     // eq(0, x, y) <=> nor(x, y)
     if (has_zero) {
-        return nor_s(vector<bx_t>(args.cbegin(), args.cend()));
+        return nor_s(args);
     }
 
     // eq(1, x, y) <=> x & y
     if (has_one) {
-        return and_s(vector<bx_t>(args.cbegin(), args.cend()));
+        return and_s(args);
     }
 
     return to_op();
@@ -22,13 +22,19 @@
 namespace boolexpr {
 
 
+// Arguments are kept in a flat vector, sorted by node serial number.
+// That makes the argument order of simplified operators reproducible.
 class ArgSet
 {
 protected:
-    std::unordered_set<bx_t> args;
+    std::vector<bx_t> args;
     virtual void insert(bx_t const &) = 0;
     virtual bx_t to_op() const = 0;
 
+    bool contains(bx_t const &) const;
+    void add(bx_t const &);
+    void remove(bx_t const &);
+
 public:
     virtual bx_t reduce() const = 0;
 };
@@ -45,9 +51,10 @@ protected:
     bx_t dominator;
 
     void insert(bx_t const &);
+    void flatten(Operator const *);
 
 public:
-    LatticeArgSet(std::vector<bx_t> const & args, BoolExpr::Kind const & kind,
+    LatticeArgSet(ArgVec const & args, BoolExpr::Kind const & kind,
                   bx_t const & identity, bx_t const & dominator);
     bx_t reduce() const;
 };
@@ -59,7 +66,7 @@ protected:
     bx_t to_op() const;
 
 public:
-    OrArgSet(std::vector<bx_t> const & args);
+    OrArgSet(ArgVec const & args);
 };
 
 
@@ -69,7 +76,7 @@ protected:
     bx_t to_op() const;
 
 public:
-    AndArgSet(std::vector<bx_t> const & args);
+    AndArgSet(ArgVec const & args);
 };
 
 
@@ -79,12 +86,19 @@ class XorArgSet : public ArgSet
     State state;
     bool parity;
 
+    // Structural hashes of args, to reject most duplicate checks
+    std::unordered_multiset<uint64_t> hashes;
+
+    bx_t find_equal(bx_t const &) const;
+    void add_arg(bx_t const &);
+    void remove_arg(bx_t const &);
+
 protected:
     void insert(bx_t const &);
     bx_t to_op() const;
 
 public:
-    XorArgSet(std::vector<bx_t> const & args);
+    XorArgSet(ArgVec const & args);
     bx_t reduce() const;
 };
 
@@ -101,7 +115,7 @@ protected:
     bx_t to_op() const;
 
 public:
-    EqArgSet(std::vector<bx_t> const & args);
+    EqArgSet(ArgVec const & args);
     bx_t reduce() const;
 };
 
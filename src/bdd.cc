@@ -0,0 +1,1116 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "boolexpr/boolexpr.h"
+#include "rewrite.h"
+#include "unique.h"
+
+
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+
+namespace boolexpr {
+
+
+static uint32_t const ONE = 0;
+static uint32_t const ZERO = 1;
+
+// Computed cache operations
+static uint32_t const OP_EMPTY = 0;
+static uint32_t const OP_ITE = 1;
+static uint32_t const OP_COFACTOR = 2;
+// Quantifiers add their kind
+static uint32_t const OP_QUANTIFY = 3;
+
+static size_t const MIN_BUCKETS = 16;
+static size_t const MIN_CACHE = 1 << 16;
+static size_t const MAX_CACHE = 1 << 22;
+static size_t const MIN_GC = 1 << 14;
+static size_t const MIN_REORDER = 1 << 12;
+
+// Sifting stops moving a variable when the BDDs grow this much
+static double const MAX_GROWTH = 1.2;
+
+
+static uint64_t
+_hash(uint64_t a, uint64_t b)
+{
+    return hash_mix((a << 32) ^ b);
+}
+
+
+BddManager::BddManager()
+    : nodes {{FREE, ONE, ONE, 0, 1}}
+    , gc_limit {MIN_GC}
+    , cache(MIN_CACHE, Entry {OP_EMPTY, 0, 0, 0, 0})
+    , auto_reorder {false}
+    , reorder_limit {MIN_REORDER}
+    , reorder_time {0}
+{}
+
+
+size_t
+BddManager::num_vars() const
+{
+    return vars.size();
+}
+
+
+size_t
+BddManager::num_nodes() const
+{
+    return nodes.size() - 1 - free_nodes.size();
+}
+
+
+void
+BddManager::ref(uint32_t edge)
+{
+    auto n = edge >> 1;
+    if (n != 0) {
+        ++nodes[n].refs;
+    }
+}
+
+
+// A dead node keeps its children referenced until gc frees it,
+// so a later make can bring it back for free.
+void
+BddManager::deref(uint32_t edge)
+{
+    auto n = edge >> 1;
+    if (n != 0) {
+        assert(nodes[n].refs > 0);
+        --nodes[n].refs;
+    }
+}
+
+
+// The terminal is below every variable
+uint32_t
+BddManager::level(uint32_t edge) const
+{
+    auto n = edge >> 1;
+    return n == 0 ? FREE : var2level[nodes[n].var];
+}
+
+
+uint32_t
+BddManager::index(var_t const & x)
+{
+    auto it = var2index.find(x);
+    if (it != var2index.end()) {
+        return it->second;
+    }
+
+    uint32_t i = vars.size();
+    vars.push_back(x);
+    var2index.insert({x, i});
+    var2level.push_back(level2var.size());
+    level2var.push_back(i);
+    buckets.emplace_back(MIN_BUCKETS, 0);
+    counts.push_back(0);
+    return i;
+}
+
+
+// Return the conjunction of the variables in xs,
+// and whether any of them are not in the manager.
+uint32_t
+BddManager::cube(vector<var_t> const & xs, bool & missing)
+{
+    vector<uint32_t> levels;
+    missing = false;
+    for (auto const & x : xs) {
+        auto it = var2index.find(x);
+        if (it == var2index.end()) {
+            missing = true;
+        }
+        else {
+            levels.push_back(var2level[it->second]);
+        }
+    }
+    std::sort(levels.begin(), levels.end());
+    levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+
+    // Build from the bottom up
+    uint32_t c = ONE;
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+        c = make(level2var[*it], c, ZERO);
+    }
+    return c;
+}
+
+
+void
+BddManager::insert(uint32_t n)
+{
+    auto & node = nodes[n];
+    auto & table = buckets[node.var];
+    auto b = _hash(node.hi, node.lo) & (table.size() - 1);
+    node.next = table[b];
+    table[b] = n;
+    ++counts[node.var];
+}
+
+
+void
+BddManager::remove(uint32_t n)
+{
+    auto const & node = nodes[n];
+    auto & table = buckets[node.var];
+    auto b = _hash(node.hi, node.lo) & (table.size() - 1);
+    for (uint32_t * p = &table[b]; *p != 0; p = &nodes[*p].next) {
+        if (*p == n) {
+            *p = node.next;
+            --counts[node.var];
+            return;
+        }
+    }
+    assert(false);  // LCOV_EXCL_LINE
+}
+
+
+// Double the buckets of one unique table
+void
+BddManager::resize(uint32_t index)
+{
+    auto & table = buckets[index];
+    vector<uint32_t> old(table.size() * 2, 0);
+    std::swap(table, old);
+    counts[index] = 0;
+    for (auto head : old) {
+        for (auto n = head; n != 0; ) {
+            auto next = nodes[n].next;
+            insert(n);
+            n = next;
+        }
+    }
+}
+
+
+// Only called between operations, when every result in use has a handle.
+// Collect whenever the table doubles since the last time.
+void
+BddManager::maybe_gc()
+{
+    if (num_nodes() > gc_limit) {
+        gc();
+    }
+
+    if (auto_reorder && num_nodes() > reorder_limit) {
+        reorder_sift();
+        reorder_limit = std::max(MIN_REORDER, 2 * num_nodes());
+    }
+
+    // Keep the cache about as big as the node table
+    if (nodes.size() > cache.size() && cache.size() < MAX_CACHE) {
+        cache.assign(cache.size() * 2, Entry {OP_EMPTY, 0, 0, 0, 0});
+    }
+}
+
+
+// Free the unreferenced nodes in stack, and any children that dies with them
+void
+BddManager::sweep(vector<uint32_t> & stack)
+{
+    while (!stack.empty()) {
+        auto n = stack.back();
+        stack.pop_back();
+        if (nodes[n].var == FREE || nodes[n].refs != 0) {
+            continue;
+        }
+
+        remove(n);
+        for (auto child : {nodes[n].hi >> 1, nodes[n].lo >> 1}) {
+            if (child != 0 && --nodes[child].refs == 0) {
+                stack.push_back(child);
+            }
+        }
+        nodes[n].var = FREE;
+        free_nodes.push_back(n);
+    }
+}
+
+
+void
+BddManager::gc()
+{
+    vector<uint32_t> stack;
+    for (uint32_t n = 1; n < nodes.size(); ++n) {
+        if (nodes[n].var != FREE && nodes[n].refs == 0) {
+            stack.push_back(n);
+        }
+    }
+    sweep(stack);
+
+    gc_limit = std::max(MIN_GC, 2 * num_nodes());
+    std::fill(cache.begin(), cache.end(), Entry {OP_EMPTY, 0, 0, 0, 0});
+}
+
+
+// Return the node (index, hi, lo), keeping the then edge regular
+uint32_t
+BddManager::make(uint32_t index, uint32_t hi, uint32_t lo)
+{
+    if (hi == lo) {
+        return hi;
+    }
+    if (hi & 1) {
+        return make(index, hi ^ 1, lo ^ 1) ^ 1;
+    }
+
+    auto const & table = buckets[index];
+    auto b = _hash(hi, lo) & (table.size() - 1);
+    for (auto n = table[b]; n != 0; n = nodes[n].next) {
+        if (nodes[n].hi == hi && nodes[n].lo == lo) {
+            return n << 1;
+        }
+    }
+
+    uint32_t n;
+    if (free_nodes.empty()) {
+        n = nodes.size();
+        nodes.push_back(Node {index, hi, lo, 0, 0});
+    }
+    else {
+        n = free_nodes.back();
+        free_nodes.pop_back();
+        nodes[n] = Node {index, hi, lo, 0, 0};
+    }
+
+    insert(n);
+    ref(hi);
+    ref(lo);
+
+    if (counts[index] > 2 * buckets[index].size()) {
+        resize(index);
+    }
+
+    return n << 1;
+}
+
+
+uint32_t
+BddManager::ite(uint32_t f, uint32_t g, uint32_t h)
+{
+    if (f == ONE) {
+        return g;
+    }
+    if (f == ZERO) {
+        return h;
+    }
+
+    // ite(f, f, h) = ite(f, 1, h), and so on
+    if (g == f) {
+        g = ONE;
+    }
+    else if (g == (f ^ 1)) {
+        g = ZERO;
+    }
+    if (h == f) {
+        h = ZERO;
+    }
+    else if (h == (f ^ 1)) {
+        h = ONE;
+    }
+
+    if (g == h) {
+        return g;
+    }
+    if (g == ONE && h == ZERO) {
+        return f;
+    }
+    if (g == ZERO && h == ONE) {
+        return f ^ 1;
+    }
+
+    // Make f and g regular, so equal calls share a cache entry
+    if (f & 1) {
+        f ^= 1;
+        std::swap(g, h);
+    }
+    uint32_t neg = g & 1;
+    g ^= neg;
+    h ^= neg;
+
+    // The cache only grows between operations
+    auto & entry = cache[_hash(_hash(OP_ITE, f), _hash(g, h))
+                         & (cache.size() - 1)];
+    if (entry.op == OP_ITE && entry.f == f && entry.g == g && entry.h == h) {
+        return entry.r ^ neg;
+    }
+
+    auto top = std::min({level(f), level(g), level(h)});
+    auto i = level2var[top];
+
+    uint32_t fs[2] = {f, f};
+    uint32_t gs[2] = {g, g};
+    uint32_t hs[2] = {h, h};
+    for (auto e : {&fs, &gs, &hs}) {
+        auto x = (*e)[0];
+        if (level(x) == top) {
+            (*e)[1] = nodes[x >> 1].hi ^ (x & 1);
+            (*e)[0] = nodes[x >> 1].lo ^ (x & 1);
+        }
+    }
+
+    auto t = ite(fs[1], gs[1], hs[1]);
+    auto e = ite(fs[0], gs[0], hs[0]);
+    auto r = make(i, t, e);
+
+    entry = Entry {OP_ITE, f, g, h, r};
+
+    return r ^ neg;
+}
+
+
+uint32_t
+BddManager::cofactor(uint32_t f, uint32_t index, bool value)
+{
+    auto lf = level(f);
+    auto lx = var2level[index];
+
+    // f does not depend on x
+    if (lf > lx) {
+        return f;
+    }
+
+    auto const & node = nodes[f >> 1];
+    if (lf == lx) {
+        return (value ? node.hi : node.lo) ^ (f & 1);
+    }
+
+    auto & entry = cache[_hash(_hash(OP_COFACTOR, f), _hash(index, value))
+                         & (cache.size() - 1)];
+    if (entry.op == OP_COFACTOR && entry.f == f && entry.g == index
+            && entry.h == value) {
+        return entry.r;
+    }
+
+    auto i = node.var;
+    auto hi = node.hi ^ (f & 1);
+    auto lo = node.lo ^ (f & 1);
+    auto t = cofactor(hi, index, value);
+    auto e = cofactor(lo, index, value);
+    auto r = make(i, t, e);
+
+    entry = Entry {OP_COFACTOR, f, index, value, r};
+    return r;
+}
+
+
+// Reduce the two cofactors of f by each variable in cube,
+// with Or (smoothing), And (consensus), or Xor (derivative).
+uint32_t
+BddManager::quantify(uint32_t f, uint32_t cube, BoolExpr::Kind kind)
+{
+    auto lf = level(f);
+
+    // Skip variables above f, which f does not depend on
+    while (cube != ONE && level(cube) < lf) {
+        if (kind == BoolExpr::XOR) {
+            return ZERO;
+        }
+        cube = nodes[cube >> 1].hi;
+    }
+
+    if (cube == ONE) {
+        return f;
+    }
+
+    uint32_t op = OP_QUANTIFY + kind;
+    auto & entry = cache[_hash(_hash(op, f), cube) & (cache.size() - 1)];
+    if (entry.op == op && entry.f == f && entry.g == cube) {
+        return entry.r;
+    }
+
+    auto const & node = nodes[f >> 1];
+    auto i = node.var;
+    auto hi = node.hi ^ (f & 1);
+    auto lo = node.lo ^ (f & 1);
+
+    uint32_t r;
+    if (level(cube) == lf) {
+        auto rest = nodes[cube >> 1].hi;
+        auto t = quantify(hi, rest, kind);
+        auto e = quantify(lo, rest, kind);
+        switch (kind) {
+            case BoolExpr::OR:
+                r = ite(t, ONE, e);
+                break;
+            case BoolExpr::AND:
+                r = ite(t, e, ZERO);
+                break;
+            default:
+                r = ite(t, e ^ 1, e);
+                break;
+        }
+    }
+    else {
+        auto t = quantify(hi, cube, kind);
+        auto e = quantify(lo, cube, kind);
+        r = make(i, t, e);
+    }
+
+    entry = Entry {op, f, cube, 0, r};
+    return r;
+}
+
+
+Bdd
+BddManager::zero()
+{
+    return Bdd(this, ZERO);
+}
+
+
+Bdd
+BddManager::one()
+{
+    return Bdd(this, ONE);
+}
+
+
+Bdd
+BddManager::var(var_t const & x)
+{
+    maybe_gc();
+    return Bdd(this, make(index(x), ONE, ZERO));
+}
+
+
+// Return the BDD of one node, given the BDDs of its arguments
+uint32_t
+BddManager::convert(bx_t const & bx, vector<uint32_t> const & args)
+{
+    if (IS_ZERO(bx)) {
+        return ZERO;
+    }
+    if (IS_ONE(bx)) {
+        return ONE;
+    }
+    if (IS_VAR(bx)) {
+        auto x = boost::static_pointer_cast<Variable const>(bx);
+        return make(index(x), ONE, ZERO);
+    }
+    if (IS_COMP(bx)) {
+        auto x = boost::static_pointer_cast<Variable const>(~bx);
+        return make(index(x), ONE, ZERO) ^ 1;
+    }
+
+    uint32_t y;
+    switch (bx->kind | 1) {
+        case BoolExpr::OR:
+            y = ZERO;
+            for (auto a : args) {
+                y = ite(y, ONE, a);
+            }
+            break;
+
+        case BoolExpr::AND:
+            y = ONE;
+            for (auto a : args) {
+                y = ite(y, a, ZERO);
+            }
+            break;
+
+        case BoolExpr::XOR:
+            y = ZERO;
+            for (auto a : args) {
+                y = ite(y, a ^ 1, a);
+            }
+            break;
+
+        case BoolExpr::EQ: {
+            // All ones, or all zeros
+            uint32_t all = ONE;
+            uint32_t none = ONE;
+            for (auto a : args) {
+                all = ite(all, a, ZERO);
+                none = ite(none, a ^ 1, ZERO);
+            }
+            y = ite(all, ONE, none);
+            break;
+        }
+
+        case BoolExpr::IMPL:
+            y = ite(args[0], args[1], ONE);
+            break;
+
+        // IfThenElse
+        default:
+            y = ite(args[0], args[1], args[2]);
+            break;
+    }
+
+    return IS_NEG(bx) ? y ^ 1 : y;
+}
+
+
+// Hold every node's result until the end,
+// so it is safe to collect or reorder between nodes.
+boost::optional<Bdd>
+BddManager::to_bdd(bx_t const & f)
+{
+    vector<uint32_t> held;
+    bool unknown = false;
+
+    auto r = postorder<uint32_t>(f,
+        [this, &held, &unknown](bx_t const & bx,
+                                vector<uint32_t> const & args) {
+            // Skip the rest of the conversion
+            if (unknown || IS_UNKNOWN(bx)) {
+                unknown = true;
+                return ZERO;
+            }
+
+            maybe_gc();
+
+            auto y = convert(bx, args);
+            ref(y);
+            held.push_back(y);
+            return y;
+        });
+
+    boost::optional<Bdd> result;
+    if (!unknown) {
+        result = Bdd(this, r);
+    }
+    for (auto y : held) {
+        deref(y);
+    }
+    return result;
+}
+
+
+bx_t
+BddManager::from_bdd(Bdd const & f)
+{
+    assert(f.mgr == this);
+
+    // Push complements down to the terminals, so there are no Not nodes
+    unordered_map<uint32_t, bx_t> memo;
+    std::function<bx_t(uint32_t)> convert = [&](uint32_t e) -> bx_t {
+        if (e == ONE) {
+            return boolexpr::one();
+        }
+        if (e == ZERO) {
+            return boolexpr::zero();
+        }
+
+        auto it = memo.find(e);
+        if (it != memo.end()) {
+            return it->second;
+        }
+
+        auto const & node = nodes[e >> 1];
+        auto x = vars[node.var];
+        auto hi = node.hi ^ (e & 1);
+        auto lo = node.lo ^ (e & 1);
+        auto y = ite_s(x, convert(hi), convert(lo));
+
+        memo.insert({e, y});
+        return y;
+    };
+
+    return convert(f.edge);
+}
+
+
+Bdd
+BddManager::ite(Bdd const & f, Bdd const & g, Bdd const & h)
+{
+    assert(f.mgr == this && g.mgr == this && h.mgr == this);
+    maybe_gc();
+    return Bdd(this, ite(f.edge, g.edge, h.edge));
+}
+
+
+vector<var_t>
+BddManager::get_order() const
+{
+    vector<var_t> order;
+    for (auto i : level2var) {
+        order.push_back(vars[i]);
+    }
+    return order;
+}
+
+
+bool
+BddManager::enable_auto_reorder(bool enable)
+{
+    auto prev = auto_reorder;
+    auto_reorder = enable;
+    return prev;
+}
+
+
+void
+BddManager::set_reorder_time_limit(double seconds)
+{
+    reorder_time = seconds;
+}
+
+
+// Swap the variables at level and level+1 in place.
+// Every node keeps its function, so edges held elsewhere stay valid.
+void
+BddManager::swap(uint32_t level)
+{
+    auto x = level2var[level];
+    auto y = level2var[level + 1];
+
+    // Only nodes of x with a child of y change
+    vector<uint32_t> moved;
+    for (auto head : buckets[x]) {
+        for (auto n = head; n != 0; n = nodes[n].next) {
+            auto hi = nodes[n].hi >> 1;
+            auto lo = nodes[n].lo >> 1;
+            if ((hi != 0 && nodes[hi].var == y)
+                    || (lo != 0 && nodes[lo].var == y)) {
+                moved.push_back(n);
+            }
+        }
+    }
+
+    for (auto n : moved) {
+        remove(n);
+    }
+
+    // f = x ? (y ? f11 : f10) : (y ? f01 : f00)
+    //   = y ? (x ? f11 : f01) : (x ? f10 : f00)
+    vector<uint32_t> stack;
+    for (auto n : moved) {
+        uint32_t fs[2] = {nodes[n].lo, nodes[n].hi};
+        uint32_t cfs[2][2];
+        for (int i = 0; i < 2; ++i) {
+            auto e = fs[i];
+            if ((e >> 1) != 0 && nodes[e >> 1].var == y) {
+                cfs[i][1] = nodes[e >> 1].hi ^ (e & 1);
+                cfs[i][0] = nodes[e >> 1].lo ^ (e & 1);
+            }
+            else {
+                cfs[i][1] = cfs[i][0] = e;
+            }
+        }
+
+        auto hi = make(x, cfs[1][1], cfs[0][1]);
+        auto lo = make(x, cfs[1][0], cfs[0][0]);
+        ref(hi);
+        ref(lo);
+
+        for (auto e : fs) {
+            deref(e);
+            if ((e >> 1) != 0 && nodes[e >> 1].refs == 0) {
+                stack.push_back(e >> 1);
+            }
+        }
+
+        nodes[n].var = y;
+        nodes[n].hi = hi;
+        nodes[n].lo = lo;
+        insert(n);
+    }
+
+    if (counts[y] > 2 * buckets[y].size()) {
+        resize(y);
+    }
+
+    level2var[level] = y;
+    level2var[level + 1] = x;
+    var2level[y] = level;
+    var2level[x] = level + 1;
+
+    // Nodes of y that only the moved nodes used
+    sweep(stack);
+}
+
+
+bool
+BddManager::expired() const
+{
+    return reorder_time > 0 && std::chrono::steady_clock::now() > deadline;
+}
+
+
+// Move one variable up, then down, then back to its best level
+void
+BddManager::sift(uint32_t index)
+{
+    auto n = level2var.size();
+    auto level = var2level[index];
+    auto best_level = level;
+    auto best_size = num_nodes();
+
+    // Go toward the nearer end first
+    bool up = level < n - 1 - level;
+    for (int pass = 0; pass < 2; ++pass, up = !up) {
+        while (!expired() && (up ? level > 0 : level < n - 1)) {
+            if (up) {
+                swap(--level);
+            }
+            else {
+                swap(level++);
+            }
+
+            auto size = num_nodes();
+            if (size < best_size) {
+                best_size = size;
+                best_level = level;
+            }
+            else if (size > MAX_GROWTH * best_size) {
+                break;
+            }
+        }
+    }
+
+    while (level > best_level) {
+        swap(--level);
+    }
+    while (level < best_level) {
+        swap(level++);
+    }
+}
+
+
+size_t
+BddManager::reorder_sift()
+{
+    deadline = std::chrono::steady_clock::now()
+             + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(reorder_time));
+    gc();
+
+    // Largest variables first
+    vector<uint32_t> order;
+    for (uint32_t i = 0; i < vars.size(); ++i) {
+        order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [this](uint32_t i, uint32_t j) { return counts[i] > counts[j]; });
+
+    for (auto i : order) {
+        if (expired()) {
+            break;
+        }
+        sift(i);
+    }
+
+    // Freed nodes may come back as new ones
+    std::fill(cache.begin(), cache.end(), Entry {OP_EMPTY, 0, 0, 0, 0});
+    return num_nodes();
+}
+
+
+// Visit all six orders of levels level ... level+2,
+// then go back to the smallest. Return how many nodes that saved.
+size_t
+BddManager::window(uint32_t level)
+{
+    static uint32_t const swaps[5] = {0, 1, 0, 1, 0};
+
+    auto size = num_nodes();
+    auto best_size = size;
+    int best = -1;
+
+    int i = 0;
+    for (; i < 5 && !expired(); ++i) {
+        swap(level + swaps[i]);
+        if (num_nodes() < best_size) {
+            best_size = num_nodes();
+            best = i;
+        }
+    }
+
+    // Swaps undo themselves
+    while (--i > best) {
+        swap(level + swaps[i]);
+    }
+
+    return size - best_size;
+}
+
+
+size_t
+BddManager::reorder_window()
+{
+    deadline = std::chrono::steady_clock::now()
+             + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<double>(reorder_time));
+    gc();
+
+    for (bool again = true; again && !expired(); ) {
+        again = false;
+        for (uint32_t level = 0; level + 2 < level2var.size(); ++level) {
+            if (expired()) {
+                break;
+            }
+            if (window(level) > 0) {
+                again = true;
+            }
+        }
+    }
+
+    std::fill(cache.begin(), cache.end(), Entry {OP_EMPTY, 0, 0, 0, 0});
+    return num_nodes();
+}
+
+
+Bdd::Bdd(BddManager * mgr, uint32_t edge)
+    : mgr {mgr}
+    , edge {edge}
+{
+    mgr->ref(edge);
+}
+
+
+Bdd::Bdd(Bdd const & other)
+    : mgr {other.mgr}
+    , edge {other.edge}
+{
+    mgr->ref(edge);
+}
+
+
+Bdd::~Bdd()
+{
+    mgr->deref(edge);
+}
+
+
+Bdd &
+Bdd::operator=(Bdd const & other)
+{
+    other.mgr->ref(other.edge);
+    mgr->deref(edge);
+    mgr = other.mgr;
+    edge = other.edge;
+    return *this;
+}
+
+
+bool
+Bdd::operator==(Bdd const & other) const
+{
+    return mgr == other.mgr && edge == other.edge;
+}
+
+
+bool
+Bdd::operator!=(Bdd const & other) const
+{
+    return !(*this == other);
+}
+
+
+bool
+Bdd::is_zero() const
+{
+    return edge == ZERO;
+}
+
+
+bool
+Bdd::is_one() const
+{
+    return edge == ONE;
+}
+
+
+Bdd
+Bdd::operator~() const
+{
+    return Bdd(mgr, edge ^ 1);
+}
+
+
+Bdd
+Bdd::operator|(Bdd const & other) const
+{
+    return mgr->ite(*this, mgr->one(), other);
+}
+
+
+Bdd
+Bdd::operator&(Bdd const & other) const
+{
+    return mgr->ite(*this, other, mgr->zero());
+}
+
+
+Bdd
+Bdd::operator^(Bdd const & other) const
+{
+    return mgr->ite(*this, ~other, other);
+}
+
+
+Bdd
+Bdd::cofactor(var_t const & x, bool value) const
+{
+    auto it = mgr->var2index.find(x);
+    if (it == mgr->var2index.end()) {
+        return *this;
+    }
+
+    mgr->maybe_gc();
+    return Bdd(mgr, mgr->cofactor(edge, it->second, value));
+}
+
+
+Bdd
+Bdd::smoothing(vector<var_t> const & xs) const
+{
+    mgr->maybe_gc();
+    bool missing;
+    auto cube = mgr->cube(xs, missing);
+    return Bdd(mgr, mgr->quantify(edge, cube, BoolExpr::OR));
+}
+
+
+Bdd
+Bdd::consensus(vector<var_t> const & xs) const
+{
+    mgr->maybe_gc();
+    bool missing;
+    auto cube = mgr->cube(xs, missing);
+    return Bdd(mgr, mgr->quantify(edge, cube, BoolExpr::AND));
+}
+
+
+// Like BoolExpr::derivative, zero if f does not depend on a variable
+Bdd
+Bdd::derivative(vector<var_t> const & xs) const
+{
+    mgr->maybe_gc();
+    bool missing;
+    auto cube = mgr->cube(xs, missing);
+    if (missing) {
+        return mgr->zero();
+    }
+    return Bdd(mgr, mgr->quantify(edge, cube, BoolExpr::XOR));
+}
+
+
+size_t
+Bdd::size() const
+{
+    unordered_set<uint32_t> seen {edge >> 1};
+    vector<uint32_t> stack {edge >> 1};
+    while (!stack.empty()) {
+        auto n = stack.back();
+        stack.pop_back();
+        if (n != 0) {
+            for (auto child : {mgr->nodes[n].hi >> 1, mgr->nodes[n].lo >> 1}) {
+                if (seen.insert(child).second) {
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+    return seen.size();
+}
+
+
+vector<var_t>
+Bdd::support() const
+{
+    unordered_set<uint32_t> seen {edge >> 1};
+    vector<uint32_t> stack {edge >> 1};
+    vector<var_t> xs;
+    unordered_set<uint32_t> indices;
+    while (!stack.empty()) {
+        auto n = stack.back();
+        stack.pop_back();
+        if (n != 0) {
+            auto const & node = mgr->nodes[n];
+            if (indices.insert(node.var).second) {
+                xs.push_back(mgr->vars[node.var]);
+            }
+            for (auto child : {node.hi >> 1, node.lo >> 1}) {
+                if (seen.insert(child).second) {
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+    std::sort(xs.begin(), xs.end(), VarLess());
+    return xs;
+}
+
+
+// Count the fraction of points where each node is one,
+// so skipped levels need no correction.
+double
+Bdd::count() const
+{
+    unordered_map<uint32_t, double> memo {{0, 1.0}};
+    std::function<double(uint32_t)> frac = [&](uint32_t e) -> double {
+        auto n = e >> 1;
+        auto it = memo.find(n);
+        double p;
+        if (it != memo.end()) {
+            p = it->second;
+        }
+        else {
+            auto const & node = mgr->nodes[n];
+            p = (frac(node.hi) + frac(node.lo)) / 2;
+            memo.insert({n, p});
+        }
+        return (e & 1) ? 1 - p : p;
+    };
+
+    return std::ldexp(frac(edge), support().size());
+}
+
+
+soln_t
+Bdd::sat() const
+{
+    if (edge == ZERO) {
+        return std::make_pair(false, boost::none);
+    }
+
+    // Every edge but zero reaches one
+    point_t point;
+    for (auto e = edge; e != ONE; ) {
+        auto const & node = mgr->nodes[e >> 1];
+        auto x = mgr->vars[node.var];
+        auto hi = node.hi ^ (e & 1);
+        if (hi != ZERO) {
+            point.insert({x, boolexpr::one()});
+            e = hi;
+        }
+        else {
+            point.insert({x, boolexpr::zero()});
+            e = node.lo ^ (e & 1);
+        }
+    }
+    return std::make_pair(true, std::move(point));
+}
+
+
+}  // namespace boolexpr
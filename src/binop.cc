@@ -14,6 +14,8 @@
 
 
 #include "boolexpr/boolexpr.h"
+#include "rewrite.h"
+#include "unique.h"
 
 
 using std::vector;
@@ -29,176 +31,99 @@ Atom::to_binop() const
 }
 
 
-bx_t
-Nor::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
-}
-
-
-bx_t
-Or::to_binop() const
+// x0 | x1 | x2 | x3 <=> (x0 | x1) | (x2 | x3)
+static bx_t
+_balance(BoolExpr::Kind kind, bx_t const * args, size_t n)
 {
-    size_t n = args.size();
-
-    if (n == 0) {               // LCOV_EXCL_LINE
-        return Or::identity();  // LCOV_EXCL_LINE
-    }                           // LCOV_EXCL_LINE
-
-    if (n == 1) {                    // LCOV_EXCL_LINE
-        return args[0]->to_binop();  // LCOV_EXCL_LINE
-    }                                // LCOV_EXCL_LINE
-
-    if (n == 2) {
-        return transform([](bx_t const & bx){return bx->to_binop();});
+    if (n == 1) {
+        return args[0];
     }
 
-    // x0 | x1 | x2 | x3 <=> (x0 | x1) | (x2 | x3)
-    size_t const mid = n / 2;
-
-    auto lo = or_(vector<bx_t>(args.cbegin(), args.cbegin() + mid));
-    auto hi = or_(vector<bx_t>(args.cbegin() + mid, args.cend()));
-
-    return lo->to_binop() | hi->to_binop();
-}
-
-
-bx_t
-Nand::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
-}
-
-
-bx_t
-And::to_binop() const
-{
-    size_t n = args.size();
-
-    if (n == 0) {                // LCOV_EXCL_LINE
-        return And::identity();  // LCOV_EXCL_LINE
-    }                            // LCOV_EXCL_LINE
-
-    if (n == 1) {                    // LCOV_EXCL_LINE
-        return args[0]->to_binop();  // LCOV_EXCL_LINE
-    }                                // LCOV_EXCL_LINE
-
     if (n == 2) {
-        return transform([](bx_t const & bx){return bx->to_binop();});
+        return make_op(kind, false, {args[0], args[1]});
     }
 
-    // x0 & x1 & x2 & x3 <=> (x0 & x1) & (x2 & x3)
     size_t const mid = n / 2;
 
-    auto lo = and_(vector<bx_t>(args.cbegin(), args.cbegin() + mid));
-    auto hi = and_(vector<bx_t>(args.cbegin() + mid, args.cend()));
+    auto lo = _balance(kind, args, mid);
+    auto hi = _balance(kind, args + mid, n - mid);
 
-    return lo->to_binop() & hi->to_binop();
-}
-
-
-bx_t
-Xnor::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
+    return make_op(kind, false, {lo, hi});
 }
 
 
-bx_t
-Xor::to_binop() const
+// Binary form of an operator, given its arguments in binary form
+static bx_t
+_binop(BoolExpr::Kind kind, vector<bx_t> const & args)
 {
     size_t n = args.size();
 
-    if (n == 0) {                // LCOV_EXCL_LINE
-        return Xor::identity();  // LCOV_EXCL_LINE
-    }                            // LCOV_EXCL_LINE
+    switch (kind) {
+        case BoolExpr::OR:
+            return (n == 0) ? Or::identity() : _balance(kind, args.data(), n);
 
-    if (n == 1) {                    // LCOV_EXCL_LINE
-        return args[0]->to_binop();  // LCOV_EXCL_LINE
-    }                                // LCOV_EXCL_LINE
+        case BoolExpr::AND:
+            return (n == 0) ? And::identity() : _balance(kind, args.data(), n);
 
-    if (n == 2) {
-        return transform([](bx_t const & bx){return bx->to_binop();});
-    }
+        case BoolExpr::XOR:
+            return (n == 0) ? Xor::identity() : _balance(kind, args.data(), n);
 
-    // x0 ^ x1 ^ x2 ^ x3 <=> (x0 ^ x1) ^ (x2 ^ x3)
-    size_t const mid = n / 2;
+        case BoolExpr::EQ: {
+            if (n < 2) {       // LCOV_EXCL_LINE
+                return one();  // LCOV_EXCL_LINE
+            }                  // LCOV_EXCL_LINE
 
-    auto lo = xor_(vector<bx_t>(args.cbegin(), args.cbegin() + mid));
-    auto hi = xor_(vector<bx_t>(args.cbegin() + mid, args.cend()));
+            if (n == 2) {
+                return make_op(kind, false, args);
+            }
 
-    return lo->to_binop() ^ hi->to_binop();
-}
+            vector<bx_t> pairs(n * (n-1) / 2);
+            size_t cnt = 0;
+            for (size_t i = 0; i < (n-1); ++i) {
+                for (size_t j = i + 1; j < n; ++j) {
+                    pairs[cnt++] = eq({args[i], args[j]});
+                }
+            }
 
+            return and_(std::move(pairs));
+        }
 
-bx_t
-Unequal::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
+        // Implies, IfThenElse
+        default:
+            return make_op(kind, false, args);
+    }
 }
 
 
-bx_t
-Equal::to_binop() const
+static bx_t
+_to_binop(bx_t const & bx, vector<bx_t> const & args)
 {
-    size_t n = args.size();
-
-    if (n < 2) {       // LCOV_EXCL_LINE
-        return one();  // LCOV_EXCL_LINE
-    }                  // LCOV_EXCL_LINE
-
-    if (n == 2) {
-        return transform([](bx_t const & bx){return bx->to_binop();});
+    if (IS_ATOM(bx)) {
+        return bx;
     }
 
-    vector<bx_t> _args(n);
-    for (size_t i = 0; i < n; ++i) {
-        _args[i] = args[i]->to_binop();
-    }
+    auto op = static_cast<Operator const *>(bx.get());
 
-    vector<bx_t> pairs(n * (n-1) / 2);
-    size_t cnt = 0;
-    for (size_t i = 0; i < (n-1); ++i) {
-        for (size_t j = i + 1; j < n; ++j) {
-            pairs[cnt++] = eq({_args[i], _args[j]});
-        }
+    // Already in binary form
+    if (args.size() == 2 || IS_NITE(op) || IS_ITE(op)) {
+        return with_args(op, args);
     }
 
-    return and_(std::move(pairs));
-}
-
-
-bx_t
-NotImplies::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
-}
-
-
-bx_t
-Implies::to_binop() const
-{
-    return transform([](bx_t const & bx){return bx->to_binop();});
-}
-
+    // Positive kinds have the lowest bit set
+    if (op->kind & 1) {
+        return _binop(op->kind, args);
+    }
 
-bx_t
-NotIfThenElse::to_binop() const
-{
-    auto op = ~shared_from_this();
-    return ~op->to_binop();
+    // ~f(x0, x1, ...) <=> ~(f(x0, x1, ...))
+    auto kind = static_cast<BoolExpr::Kind>(op->kind | 1);
+    return ~_binop(kind, args);
 }
 
 
 bx_t
-IfThenElse::to_binop() const
+Operator::to_binop() const
 {
-    return transform([](bx_t const & bx){return bx->to_binop();});
+    return postorder_rewrite(shared_from_this(), _to_binop);
 }
 
 
@@ -13,11 +13,14 @@
 // limitations under the License.
 
 
+#include <algorithm>
+#include <new>
+
 #include "boolexpr/boolexpr.h"
+#include "unique.h"
 
 
-using std::make_shared;
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::unordered_set;
 using std::vector;
 
@@ -25,11 +28,25 @@ using std::vector;
 namespace boolexpr {
 
 
+static std::atomic<uint64_t> _serial {0};
+
+
 BoolExpr::BoolExpr(Kind kind)
-    : kind {kind}
+    : refs {0}
+    , pooled {false}
+    , supp {nullptr}
+    , shash {hash_mix(kind)}
+    , kind {kind}
+    , serial {_serial.fetch_add(1, std::memory_order_relaxed)}
 {}
 
 
+BoolExpr::~BoolExpr()
+{
+    delete supp.load();
+}
+
+
 Atom::Atom(Kind kind)
     : BoolExpr(kind)
 {}
@@ -75,7 +92,9 @@ Literal::Literal(Kind kind, Context * const ctx, id_t id)
     : Atom(kind)
     , ctx {ctx}
     , id {id}
-{}
+{
+    shash = hash_mix((static_cast<uint64_t>(id) << 8) | kind);
+}
 
 
 Complement::Complement(Context * const ctx, id_t id)
@@ -88,18 +107,67 @@ Variable::Variable(Context * const ctx, id_t id)
 {}
 
 
+ArgVec::ArgVec(vector<bx_t> const & args)
+    : n {args.size()}
+{
+    bx_t * p = small;
+    if (n > INLINE) {
+        large = static_cast<bx_t *>(::operator new(n * sizeof(bx_t)));
+        p = large;
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        new (p + i) bx_t(args[i]);
+    }
+}
+
+
+ArgVec::~ArgVec()
+{
+    auto p = const_cast<bx_t *>(data());
+
+    for (size_t i = 0; i < n; ++i) {
+        p[i].~bx_t();
+    }
+
+    if (n > INLINE) {
+        ::operator delete(large);
+    }
+}
+
+
 Operator::Operator(Kind kind, bool simple, vector<bx_t> const & args)
     : BoolExpr(kind)
+    , simplified {nullptr}
     , simple {simple}
     , args {args}
-{}
+{
+    summarize_args();
+}
 
 
 Operator::Operator(Kind kind, bool simple, vector<bx_t> const && args)
     : BoolExpr(kind)
+    , simplified {nullptr}
     , simple {simple}
     , args {args}
-{}
+{
+    summarize_args();
+}
+
+
+Operator::~Operator()
+{
+    auto & table = unique_table();
+    if (table.size() > 0) {
+        table.erase(this);
+    }
+
+    auto bx = simplified.load();
+    if (bx != nullptr && bx != this) {
+        intrusive_ptr_release(bx);
+    }
+}
 
 
 LatticeOperator::LatticeOperator(Kind kind, bool simple,
@@ -216,84 +284,84 @@ Xor::identity()
 op_t
 Nor::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Nor>(false, args);
+    return make_op(NOR, false, args);
 }
 
 
 op_t
 Or::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Or>(false, args);
+    return make_op(OR, false, args);
 }
 
 
 op_t
 Nand::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Nand>(false, args);
+    return make_op(NAND, false, args);
 }
 
 
 op_t
 And::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<And>(false, args);
+    return make_op(AND, false, args);
 }
 
 
 op_t
 Xnor::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Xnor>(false, args);
+    return make_op(XNOR, false, args);
 }
 
 
 op_t
 Xor::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Xor>(false, args);
+    return make_op(XOR, false, args);
 }
 
 
 op_t
 Unequal::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Unequal>(false, args);
+    return make_op(NEQ, false, args);
 }
 
 
 op_t
 Equal::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Equal>(false, args);
+    return make_op(EQ, false, args);
 }
 
 
 op_t
 NotImplies::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<NotImplies>(false, args[0], args[1]);
+    return make_op(NIMPL, false, {args[0], args[1]});
 }
 
 
 op_t
 Implies::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<Implies>(false, args[0], args[1]);
+    return make_op(IMPL, false, {args[0], args[1]});
 }
 
 
 op_t
 NotIfThenElse::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<NotIfThenElse>(false, args[0], args[1], args[2]);
+    return make_op(NITE, false, {args[0], args[1], args[2]});
 }
 
 
 op_t
 IfThenElse::from_args(vector<bx_t> const && args) const
 {
-    return make_shared<IfThenElse>(false, args[0], args[1], args[2]);
+    return make_op(ITE, false, {args[0], args[1], args[2]});
 }
 
 
@@ -414,52 +482,174 @@ And::is_dnf() const
 }
 
 
-unordered_set<var_t>
-BoolExpr::support() const
+namespace {
+
+using node_pair_t = std::pair<BoolExpr const *, BoolExpr const *>;
+
+struct NodePairHash
 {
-    auto self = shared_from_this();
+    size_t operator()(node_pair_t const & p) const
+    {
+        return std::hash<BoolExpr const *>()(p.first)
+               ^ (std::hash<BoolExpr const *>()(p.second) << 1);
+    }
+};
 
-    unordered_set<var_t> s;
+}  // namespace
 
-    for (auto it = dfs_iter(self); it != dfs_iter(); ++it) {
-        if (IS_VAR(*it)) {
-            s.insert(static_pointer_cast<Variable const>(*it));
+
+bool
+BoolExpr::equals_structurally(bx_t const & other) const
+{
+    unordered_set<node_pair_t, NodePairHash> visited;
+    vector<node_pair_t> stack {{this, other.get()}};
+
+    while (stack.size() > 0) {
+        auto a = stack.back().first;
+        auto b = stack.back().second;
+        stack.pop_back();
+
+        if (a == b) {
+            continue;
         }
-        else if (IS_COMP(*it)) {
-            s.insert(static_pointer_cast<Variable const>(~*it));
+
+        if (a->shash != b->shash || a->kind != b->kind) {
+            return false;
+        }
+
+        // Literals are unique per Context,
+        // so two distinct ones match only if they share a name.
+        // The kinds already agree on polarity.
+        if (IS_ATOM(a)) {
+            if (IS_CONST(a)) {
+                continue;
+            }
+            auto lit_a = static_cast<Literal const *>(a);
+            auto lit_b = static_cast<Literal const *>(b);
+            if (lit_a->ctx != lit_b->ctx
+                    && lit_a->to_string() == lit_b->to_string()) {
+                continue;
+            }
+            return false;
+        }
+
+        auto op_a = static_cast<Operator const *>(a);
+        auto op_b = static_cast<Operator const *>(b);
+        if (op_a->args.size() != op_b->args.size()) {
+            return false;
+        }
+
+        if (visited.insert({a, b}).second) {
+            for (size_t i = 0; i < op_a->args.size(); ++i) {
+                stack.push_back({op_a->args[i].get(), op_b->args[i].get()});
+            }
         }
     }
 
-    return std::move(s);
+    return true;
 }
 
 
-uint32_t
-BoolExpr::degree() const
+// Compute the support of bx from the supports of its arguments,
+// and cache it, unless another thread got there first.
+static void
+_cache_support(BoolExpr const * bx,
+               std::atomic<vector<Variable const *> const *> & supp)
 {
-    return support().size();
+    auto xs = new vector<Variable const *>();
+
+    if (IS_VAR(bx)) {
+        xs->push_back(static_cast<Variable const *>(bx));
+    }
+    else if (IS_COMP(bx)) {
+        auto x = abs(lit_t(static_cast<Literal const *>(bx)));
+        xs->push_back(static_cast<Variable const *>(x.get()));
+    }
+    else if (IS_OP(bx)) {
+        auto op = static_cast<Operator const *>(bx);
+        for (bx_t const & arg : op->args) {
+            auto const & ys = arg->support_vars();
+            xs->insert(xs->end(), ys.cbegin(), ys.cend());
+        }
+        std::sort(xs->begin(), xs->end(), VarLess());
+        xs->erase(std::unique(xs->begin(), xs->end()), xs->end());
+    }
+
+    vector<Variable const *> const * expected = nullptr;
+    if (!supp.compare_exchange_strong(expected, xs)) {
+        delete xs;
+    }
 }
 
 
-op_t
-Operator::transform(std::function<bx_t(bx_t const &)> f) const
+// Every operator under this node that has no support yet gets one,
+// bottom-up, so later queries from other roots stop there.
+vector<Variable const *> const &
+BoolExpr::support_vars() const
 {
-    uint32_t mod_count = 0;
-    size_t n = args.size();
-    vector<bx_t> _args(n);
-
-    for (size_t i = 0; i < n; ++i) {
-        auto arg = args[i];
-        auto _arg = f(arg);
-        mod_count += (_arg != arg);
-        _args[i] = _arg;
+    auto cached = supp.load(std::memory_order_acquire);
+    if (cached != nullptr) {
+        return *cached;
     }
 
-    if (mod_count) {
-        return from_args(std::move(_args));
+    // (node, arguments pushed)
+    vector<std::pair<BoolExpr const *, bool>> stack {{this, false}};
+
+    while (!stack.empty()) {
+        auto bx = stack.back().first;
+
+        if (bx->supp.load(std::memory_order_acquire) != nullptr) {
+            stack.pop_back();
+        }
+        else if (IS_OP(bx) && !stack.back().second) {
+            stack.back().second = true;
+            auto op = static_cast<Operator const *>(bx);
+            for (bx_t const & arg : op->args) {
+                if (IS_OP(arg)
+                        && arg->supp.load(std::memory_order_acquire) == nullptr) {
+                    stack.push_back({arg.get(), false});
+                }
+            }
+        }
+        else {
+            stack.pop_back();
+            _cache_support(bx, bx->supp);
+        }
     }
 
-    return static_pointer_cast<Operator const>(shared_from_this());
+    return *supp.load(std::memory_order_acquire);
+}
+
+
+unordered_set<var_t>
+BoolExpr::support() const
+{
+    auto const & xs = support_vars();
+    return unordered_set<var_t>(xs.cbegin(), xs.cend());
+}
+
+
+uint32_t
+BoolExpr::degree() const
+{
+    return support_vars().size();
+}
+
+
+// Keep the variables that appear in the support of f
+static vector<var_t>
+_in_support(BoolExpr const * f, vector<var_t> const & xs)
+{
+    auto const & support = f->support_vars();
+
+    vector<var_t> ys;
+    for (var_t const & x : xs) {
+        if (std::binary_search(support.cbegin(), support.cend(),
+                               x.get(), VarLess())) {
+            ys.push_back(x);
+        }
+    }
+    return ys;
 }
 
 
@@ -486,12 +676,20 @@ BoolExpr::expand(vector<var_t> const & xs) const
 }
 
 
-// FIXME(cjdrake): Implement these as reductions
+// Small functions reduce cofactors in a truth table,
+// instead of building all 2^n of them.
 bx_t
 BoolExpr::smoothing(vector<var_t> const & xs) const
 {
     auto self = shared_from_this();
-    return or_s(vector<bx_t>(cf_iter(self, xs), cf_iter()));
+
+    auto table = truth_table(self);
+    if (table) {
+        return table->smoothing(xs).to_bx();
+    }
+
+    auto ys = _in_support(this, xs);
+    return or_s(vector<bx_t>(cf_iter(self, ys), cf_iter()));
 }
 
 
@@ -499,14 +697,33 @@ bx_t
 BoolExpr::consensus(vector<var_t> const & xs) const
 {
     auto self = shared_from_this();
-    return and_s(vector<bx_t>(cf_iter(self, xs), cf_iter()));
+
+    auto table = truth_table(self);
+    if (table) {
+        return table->consensus(xs).to_bx();
+    }
+
+    auto ys = _in_support(this, xs);
+    return and_s(vector<bx_t>(cf_iter(self, ys), cf_iter()));
 }
 
 
 bx_t
 BoolExpr::derivative(vector<var_t> const & xs) const
 {
+    // f does not depend on a variable outside its support
+    auto ys = _in_support(this, xs);
+    if (ys.size() < xs.size()) {
+        return zero();
+    }
+
     auto self = shared_from_this();
+
+    auto table = truth_table(self);
+    if (table) {
+        return table->derivative(xs).to_bx();
+    }
+
     return xor_s(vector<bx_t>(cf_iter(self, xs), cf_iter()));
 }
 
@@ -20,7 +20,7 @@
 #include "bxcffi.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::string;
 using std::vector;
 
@@ -82,6 +82,23 @@ boolexpr_Context_get_var(CONTEXT c_self, STRING c_name)
 }
 
 
+ARRAY
+boolexpr_Context_get_vars(CONTEXT c_self, STRING c_prefix, size_t n,
+                          size_t const * starts, size_t const * stops)
+{
+    auto self = reinterpret_cast<Context * const>(c_self);
+    string prefix { c_prefix };
+
+    vector<std::pair<size_t, size_t>> dims;
+    for (size_t i = 0; i < n; ++i) {
+        dims.push_back({starts[i], stops[i]});
+    }
+
+    auto xs = self->get_vars(prefix, dims);
+    return new Array(vector<bx_t>(xs.cbegin(), xs.cend()));
+}
+
+
 void
 boolexpr_String_del(STRING c_str)
 {
@@ -667,6 +684,14 @@ boolexpr_BoolExpr_size(BX c_self)
 }
 
 
+uint32_t
+boolexpr_BoolExpr_dag_size(BX c_self)
+{
+    auto self = reinterpret_cast<BoolExprProxy const * const>(c_self);
+    return self->bx->dag_size();
+}
+
+
 bool
 boolexpr_BoolExpr_is_cnf(BX c_self)
 {
@@ -902,7 +927,8 @@ boolexpr_Operator_args(BX c_self)
 {
     auto self = reinterpret_cast<BoolExprProxy const * const>(c_self);
     auto op = static_pointer_cast<Operator const>(self->bx);
-    return new VecProxy<bx_t>(op->args);
+    auto args = vector<bx_t>(op->args.cbegin(), op->args.cend());
+    return new VecProxy<bx_t>(args);
 }
 
 
@@ -135,7 +135,7 @@ struct SatIterProxy
     sat_iter it;
 
     SatIterProxy(bx_t const & bx)
-        : it {sat_iter(bx)}
+        : it {bx}
     {}
 
     void next() { ++it; }
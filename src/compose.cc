@@ -14,9 +14,11 @@
 
 
 #include "boolexpr/boolexpr.h"
+#include "rewrite.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
+using std::vector;
 
 
 namespace boolexpr {
@@ -52,7 +54,40 @@ Variable::compose(var2bx_t const & var2bx) const
 bx_t
 Operator::compose(var2bx_t const & var2bx) const
 {
-    return transform([&var2bx](bx_t const & bx){return bx->compose(var2bx);});
+    auto f = [&var2bx] (bx_t const & bx, vector<bx_t> const & args) {
+        if (IS_ATOM(bx)) {
+            return bx->compose(var2bx);
+        }
+        auto op = static_cast<Operator const *>(bx.get());
+        return with_args(op, args);
+    };
+    return postorder_rewrite(shared_from_this(), f);
+}
+
+
+bx_t
+BoolExpr::compose_dense(Context const * ctx, dense_var2bx_t const & var2bx,
+                        bool simplify) const
+{
+    auto f = [ctx, &var2bx, simplify]
+             (bx_t const & bx, vector<bx_t> const & args) -> bx_t {
+        if (IS_LIT(bx)) {
+            auto lit = static_cast<Literal const *>(bx.get());
+            auto i = lit->id >> 1;
+            if (lit->ctx == ctx && i < var2bx.size() && var2bx[i]) {
+                return IS_VAR(bx) ? var2bx[i] : ~var2bx[i];
+            }
+        }
+
+        if (IS_ATOM(bx)) {
+            return bx;
+        }
+
+        auto op = static_cast<Operator const *>(bx.get());
+        auto y = with_args(op, args);
+        return simplify ? y->simplify() : y;
+    };
+    return postorder_rewrite(shared_from_this(), f);
 }
 
 
@@ -16,16 +16,13 @@
 #include "boolexpr/boolexpr.h"
 
 
-using std::make_shared;
-
-
 namespace boolexpr {
 
 
 zero_t
 zero()
 {
-    static auto _zero = make_shared<Zero>();
+    static auto _zero = zero_t(new Zero());
     return _zero;
 }
 
@@ -33,7 +30,7 @@ zero()
 one_t
 one()
 {
-    static auto _one = make_shared<One>();
+    static auto _one = one_t(new One());
     return _one;
 }
 
@@ -41,7 +38,7 @@ one()
 log_t
 logical()
 {
-    static auto _log = make_shared<Logical>();
+    static auto _log = log_t(new Logical());
     return _log;
 }
 
@@ -49,7 +46,7 @@ logical()
 ill_t
 illogical()
 {
-    static auto _ill = make_shared<Illogical>();
+    static auto _ill = ill_t(new Illogical());
     return _ill;
 }
 
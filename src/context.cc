@@ -13,49 +13,332 @@
 // limitations under the License.
 
 
+#include <algorithm>
+#include <sstream>
+
 #include "boolexpr/boolexpr.h"
 
 
-using std::make_shared;
+using boost::static_pointer_cast;
+using std::pair;
 using std::string;
+using std::vector;
 
 
 namespace boolexpr {
 
 
+// Segment k holds SEGMENT_BASE << k entries,
+// starting at index SEGMENT_BASE * (2^k - 1).
+static size_t const SEGMENT_BASE = 64;
+
+
 Context::Context()
     : id {0}
-{}
+{
+    for (size_t i = 0; i < NUM_SEGMENTS; ++i) {
+        id2name[i] = nullptr;
+        id2lit[i] = nullptr;
+        id2block_name[i] = nullptr;
+    }
+}
+
+
+Context::~Context()
+{
+    for (size_t i = 0; i < NUM_SEGMENTS; ++i) {
+        delete [] id2name[i].load();
+        delete [] id2lit[i].load();
+
+        auto names = id2block_name[i].load();
+        if (names != nullptr) {
+            for (size_t j = 0; j < (SEGMENT_BASE << i); ++j) {
+                delete names[j].load();
+            }
+            delete [] names;
+        }
+    }
+}
+
+
+static void
+_locate(size_t index, size_t & k, size_t & offset)
+{
+    unsigned long long j = index / SEGMENT_BASE + 1;
+#if defined(__GNUC__)
+    k = 63 - __builtin_clzll(j);
+#else
+    k = 0;
+    while (j >>= 1) {
+        ++k;
+    }
+#endif
+    offset = index - SEGMENT_BASE * ((size_t(1) << k) - 1);
+}
+
+
+template <typename T>
+static T &
+_slot(std::atomic<T *> const * segments, size_t index)
+{
+    size_t k, offset;
+    _locate(index, k, offset);
+    return segments[k].load(std::memory_order_acquire)[offset];
+}
+
+
+// Make sure the segments cover indices [0, n)
+template <typename T>
+static void
+_reserve(std::atomic<T *> * segments, size_t n)
+{
+    if (n == 0) {
+        return;
+    }
+
+    size_t last, offset;
+    _locate(n - 1, last, offset);
+
+    for (size_t k = 0; k <= last; ++k) {
+        if (segments[k].load(std::memory_order_acquire) == nullptr) {
+            auto segment = new T[SEGMENT_BASE << k]();
+            T * expected = nullptr;
+            if (!segments[k].compare_exchange_strong(expected, segment)) {
+                delete [] segment;
+            }
+        }
+    }
+}
+
+
+// Return the name of the variable at row-major offset in a block
+static string
+_block_name(string const & prefix,
+            vector<pair<size_t, size_t>> const & dims, size_t offset)
+{
+    vector<size_t> indices(dims.size());
+    for (size_t i = dims.size(); i-- > 0;) {
+        auto n = dims[i].second - dims[i].first;
+        indices[i] = dims[i].first + offset % n;
+        offset /= n;
+    }
+
+    std::ostringstream oss;
+    oss << prefix << "[";
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (i != 0) {
+            oss << ",";
+        }
+        oss << indices[i];
+    }
+    oss << "]";
+
+    return oss.str();
+}
+
+
+// Create the literals for a new variable with this id
+var_t
+Context::add_var(id_t id)
+{
+    _reserve(id2name, (id >> 1) + 1);
+    _reserve(id2lit, id + 2);
+    _reserve(id2block_name, (id >> 1) + 1);
+
+    auto x = var_t(new Variable(this, id + 1));
+    _slot(id2lit, id) = lit_t(new Complement(this, id));
+    _slot(id2lit, id + 1) = x;
+    return x;
+}
 
 
 var_t
 Context::get_var(string name)
 {
-    auto search = vars.find(name);
-    if (search == vars.end()) {
-        auto xn = make_shared<Complement>(this, id++);
-        auto x = make_shared<Variable>(this, id++);
-        vars.insert({name, x});
-        id2name.insert({xn->id >> 1, name});
-        id2lit.insert({xn->id, xn});
-        id2lit.insert({x->id, x});
-        return x;
+    auto & shard = shards[std::hash<string>()(name) % NUM_SHARDS];
+    std::lock_guard<std::mutex> shard_lock(shard.mutex);
+
+    auto search = shard.vars.find(name);
+    if (search != shard.vars.end()) {
+        return search->second;
     }
-    return search->second;
+
+    {
+        std::lock_guard<std::mutex> lock(blocks_mutex);
+
+        auto x = get_block_var(name);
+        if (x) {
+            return x;
+        }
+
+        auto pos = name.rfind('[');
+        if (pos != string::npos) {
+            indexed.insert(name.substr(0, pos));
+        }
+    }
+
+    auto first = id.fetch_add(2);
+    auto x = add_var(first);
+    _slot(id2name, first >> 1) = name;
+    shard.vars.insert({name, x});
+    return x;
+}
+
+
+vector<var_t>
+Context::get_vars(string prefix, vector<pair<size_t, size_t>> const & dims)
+{
+    size_t size = 1;
+    for (auto const & dim : dims) {
+        size *= dim.second - dim.first;
+    }
+
+    vector<var_t> xs;
+    xs.reserve(size);
+
+    {
+        std::lock_guard<std::mutex> lock(blocks_mutex);
+
+        auto search = prefix2block.find(prefix);
+
+        // Same block as before
+        if (search != prefix2block.end()
+                && blocks[search->second].dims == dims) {
+            auto first = blocks[search->second].first;
+            for (size_t i = 0; i < size; ++i) {
+                auto x = _slot(id2lit, first + 2 * i + 1);
+                xs.push_back(static_pointer_cast<Variable const>(x));
+            }
+            return xs;
+        }
+
+        if (search == prefix2block.end() && indexed.count(prefix) == 0) {
+            if (size == 0) {
+                return xs;
+            }
+
+            id_t first = id.fetch_add(2 * size);
+            prefix2block.insert({prefix, blocks.size()});
+            blocks.push_back({prefix, dims, first, size});
+
+            for (size_t i = 0; i < size; ++i) {
+                xs.push_back(add_var(first + 2 * i));
+            }
+
+            return xs;
+        }
+    }
+
+    // Some of these names might already exist.
+    // Release the block lock first, b/c get_var takes a shard lock.
+    for (size_t i = 0; i < size; ++i) {
+        xs.push_back(get_var(_block_name(prefix, dims, i)));
+    }
+
+    return xs;
+}
+
+
+// Return the block variable with this name, or nullptr
+var_t
+Context::get_block_var(string const & name) const
+{
+    auto pos = name.rfind('[');
+    if (pos == string::npos || name.back() != ']') {
+        return nullptr;
+    }
+
+    auto search = prefix2block.find(name.substr(0, pos));
+    if (search == prefix2block.end()) {
+        return nullptr;
+    }
+
+    auto const & block = blocks[search->second];
+
+    // Parse the comma-separated indices
+    vector<size_t> indices {0};
+    for (size_t i = pos + 1; i < name.size() - 1; ++i) {
+        auto c = name[i];
+        if (c == ',') {
+            indices.push_back(0);
+        }
+        else if ('0' <= c && c <= '9') {
+            indices.back() = 10 * indices.back() + (c - '0');
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    if (indices.size() != block.dims.size()) {
+        return nullptr;
+    }
+
+    size_t offset = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        auto const & dim = block.dims[i];
+        if (indices[i] < dim.first || indices[i] >= dim.second) {
+            return nullptr;
+        }
+        offset = offset * (dim.second - dim.first) + (indices[i] - dim.first);
+    }
+
+    // Reject non-canonical spellings, like "x[01]"
+    if (_block_name(block.prefix, block.dims, offset) != name) {
+        return nullptr;
+    }
+
+    auto x = _slot(id2lit, block.first + 2 * offset + 1);
+    return static_pointer_cast<Variable const>(x);
 }
 
 
-string
+string const &
 Context::get_name(id_t id) const
 {
-    return id2name.find(id >> 1)->second;
+    auto const & name = _slot(id2name, id >> 1);
+    if (!name.empty()) {
+        return name;
+    }
+
+    // A block variable, so format its name the first time
+    auto & block_name = _slot(id2block_name, id >> 1);
+    auto ptr = block_name.load(std::memory_order_acquire);
+    if (ptr != nullptr) {
+        return *ptr;
+    }
+
+    std::lock_guard<std::mutex> lock(blocks_mutex);
+
+    ptr = block_name.load(std::memory_order_relaxed);
+    if (ptr == nullptr) {
+        auto formatted = new string();
+
+        // Find the last block that starts at or before this id
+        auto it = std::upper_bound(
+            blocks.cbegin(), blocks.cend(), id,
+            [](id_t id, VarBlock const & block) { return id < block.first; }
+        );
+        if (it != blocks.cbegin()) {
+            auto const & block = *(--it);
+            auto offset = (id - block.first) >> 1;
+            if (offset < block.size) {
+                *formatted = _block_name(block.prefix, block.dims, offset);
+            }
+        }
+
+        block_name.store(formatted, std::memory_order_release);
+        ptr = formatted;
+    }
+
+    return *ptr;
 }
 
 
-lit_t
+lit_t const &
 Context::get_lit(id_t id) const
 {
-    return id2lit.find(id)->second;
+    return _slot(id2lit, id);
 }
 
 
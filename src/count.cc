@@ -13,7 +13,10 @@
 // limitations under the License.
 
 
+#include <limits>
+
 #include "boolexpr/boolexpr.h"
+#include "unique.h"
 
 
 namespace boolexpr {
@@ -29,14 +32,7 @@ Atom::depth() const
 uint32_t
 Operator::depth() const
 {
-    uint32_t max_depth = 0;
-    for (bx_t const & arg : args) {
-        auto depth = arg->depth();
-        if (depth > max_depth) {
-            max_depth = depth;
-        }
-    }
-    return max_depth + 1;
+    return _depth;
 }
 
 
@@ -50,11 +46,65 @@ Atom::size() const
 uint32_t
 Operator::size() const
 {
-    uint32_t size = 0;
+    return _size;
+}
+
+
+bool
+Operator::has_ill() const
+{
+    return _has_ill;
+}
+
+
+// Each argument has already summarized itself,
+// so this costs one pass over the arguments, even for a shared DAG.
+void
+Operator::summarize_args()
+{
+    // Tree size grows exponentially with sharing, so it saturates.
+    uint64_t const max_size = std::numeric_limits<uint32_t>::max();
+
+    uint32_t max_depth = 0;
+    uint64_t size = 1;
+    uint64_t h = hash_mix(kind);
+    auto has_ill = false;
     for (bx_t const & arg : args) {
+        h = hash_mix(h + arg->structural_hash());
+
+        if (IS_OP(arg)) {
+            has_ill |= static_cast<Operator const *>(arg.get())->_has_ill;
+        }
+        else {
+            has_ill |= IS_ILL(arg);
+        }
+
+        auto depth = arg->depth();
+        if (depth > max_depth) {
+            max_depth = depth;
+        }
         size += arg->size();
+        if (size > max_size) {
+            size = max_size;
+        }
+    }
+
+    _depth = max_depth + 1;
+    _size = static_cast<uint32_t>(size);
+    _has_ill = has_ill;
+    shash = h;
+}
+
+
+uint32_t
+BoolExpr::dag_size() const
+{
+    uint32_t size = 0;
+    auto self = shared_from_this();
+    for (auto it = dfs_iter(self); it != dfs_iter(); ++it) {
+        ++size;
     }
-    return size + 1;
+    return size;
 }
 
 
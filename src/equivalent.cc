@@ -23,7 +23,15 @@ bool
 BoolExpr::equiv(bx_t const & other) const
 {
     auto self = shared_from_this();
-    auto soln = (self ^ other)->sat();
+    auto y = self ^ other;
+
+    // Small functions compare truth tables, instead of calling SAT
+    auto table = truth_table(y);
+    if (table) {
+        return table->is_zero();
+    }
+
+    auto soln = y->sat();
     return !soln.first;
 }
 
@@ -0,0 +1,303 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <unordered_map>
+#include <vector>
+
+#include "boolexpr/boolexpr.h"
+#include "eval.h"
+
+
+using boost::static_pointer_cast;
+using std::unordered_map;
+using std::vector;
+
+
+namespace boolexpr {
+
+
+namespace {
+
+struct Frame {
+    Operator const * op;
+    uint32_t i;
+    // Value so far, or the value of the first argument of Implies and ITE
+    value_t acc;
+    // Eq: mask of the values seen; ITE: the value of d1
+    uint8_t aux;
+};
+
+} // namespace
+
+
+// Initialize a frame for a positive operator kind
+static Frame
+_frame(Operator const * op)
+{
+    auto kind = static_cast<value_t>(op->kind | 1);
+    auto acc = (kind == BoolExpr::AND) ? BoolExpr::ONE : BoolExpr::ZERO;
+    return {op, 0, acc, 0};
+}
+
+
+// Feed the value of the next argument into a frame.
+// Return the value of the (positive) operator if it is known,
+// otherwise -1 to continue with the next argument.
+// Illogical takes precedence over every other value,
+// so a deciding value only skips the other arguments through _settled.
+static int
+_step(Frame & f, value_t v)
+{
+    auto i = f.i++;
+
+    if (v == BoolExpr::ILL) {
+        return BoolExpr::ILL;
+    }
+
+    switch (f.op->kind | 1) {
+        case BoolExpr::OR:
+            if (v == BoolExpr::ONE) {
+                f.acc = BoolExpr::ONE;
+            }
+            else if (v == BoolExpr::LOG && f.acc == BoolExpr::ZERO) {
+                f.acc = BoolExpr::LOG;
+            }
+            return -1;
+
+        case BoolExpr::AND:
+            if (v == BoolExpr::ZERO) {
+                f.acc = BoolExpr::ZERO;
+            }
+            else if (v == BoolExpr::LOG && f.acc == BoolExpr::ONE) {
+                f.acc = BoolExpr::LOG;
+            }
+            return -1;
+
+        case BoolExpr::XOR:
+            if (v == BoolExpr::LOG || f.acc == BoolExpr::LOG) {
+                f.acc = BoolExpr::LOG;
+            }
+            else {
+                f.acc = static_cast<value_t>(f.acc ^ v);
+            }
+            return -1;
+
+        case BoolExpr::EQ:
+            f.aux |= 1 << v;
+            return -1;
+
+        case BoolExpr::IMPL:
+            if (i == 0) {
+                f.acc = v;
+                return -1;
+            }
+            // 0 => q <=> p => 1 <=> 1
+            if (f.acc == BoolExpr::ZERO || v == BoolExpr::ONE) {
+                return BoolExpr::ONE;
+            }
+            // 1 => q <=> q
+            if (f.acc == BoolExpr::ONE) {
+                return v;
+            }
+            // p => 0 <=> ~p
+            if (v == BoolExpr::ZERO) {
+                return value_not(f.acc);
+            }
+            return BoolExpr::LOG;
+
+        // IfThenElse
+        default:
+            if (i == 0) {
+                f.acc = v;
+                return -1;
+            }
+            if (i == 1) {
+                f.aux = v;
+                return -1;
+            }
+            // 1 ? d1 : d0 <=> d1
+            if (f.acc == BoolExpr::ONE) {
+                return f.aux;
+            }
+            // 0 ? d1 : d0 <=> d0
+            if (f.acc == BoolExpr::ZERO) {
+                return v;
+            }
+            // X ? d1 : d1 <=> d1
+            return (v == f.aux && v >> 2 == 0) ? v : BoolExpr::LOG;
+    }
+}
+
+
+// Return the end of the arguments that can only change the value of a frame
+// by being illogical, starting with the next one, or f.i if there are none
+static uint32_t
+_settled(Frame const & f)
+{
+    switch (f.op->kind | 1) {
+        case BoolExpr::OR:
+            return f.acc == BoolExpr::ONE ? f.op->args.size() : f.i;
+        case BoolExpr::AND:
+            return f.acc == BoolExpr::ZERO ? f.op->args.size() : f.i;
+        // 0 => q <=> 1
+        case BoolExpr::IMPL:
+            return (f.i == 1 && f.acc == BoolExpr::ZERO) ? 2 : f.i;
+        // 0 ? d1 : d0 <=> d0, 1 ? d1 : d0 <=> d1
+        case BoolExpr::ITE:
+            if (f.i == 1 && f.acc == BoolExpr::ZERO) {
+                return 2;
+            }
+            return (f.i == 2 && f.acc == BoolExpr::ONE) ? 3 : f.i;
+        default:
+            return f.i;
+    }
+}
+
+
+// Return the value of a frame after its last argument
+static value_t
+_finish(Frame const & f)
+{
+    switch (f.op->kind | 1) {
+        case BoolExpr::EQ:
+            if (f.aux & (1 << BoolExpr::LOG)) {
+                return BoolExpr::LOG;
+            }
+            // eq(0, 1) <=> 0
+            return (f.aux == 3) ? BoolExpr::ZERO : BoolExpr::ONE;
+        // Implies and ITE only get here if their last argument was skipped
+        case BoolExpr::IMPL:
+            return BoolExpr::ONE;
+        case BoolExpr::ITE:
+            return static_cast<value_t>(f.aux);
+        // Or, And, Xor
+        default:
+            return f.acc;
+    }
+}
+
+
+// Evaluate the DAG under root, without recursion.
+// leaf(lit) returns the value of a literal,
+// and lit_ill says whether that can be illogical.
+// Each unique operator is evaluated at most once,
+// and arguments that can no longer change a value are skipped.
+template <typename Leaf>
+static value_t
+_eval(BoolExpr const * root, Leaf leaf, bool lit_ill)
+{
+    auto atom = [&leaf] (BoolExpr const * bx) {
+        return IS_LIT(bx) ? leaf(static_cast<Literal const *>(bx)) : bx->kind;
+    };
+
+    if (!IS_OP(root)) {
+        return atom(root);
+    }
+
+    unordered_map<BoolExpr const *, value_t> memo;
+    vector<Frame> stack {_frame(static_cast<Operator const *>(root))};
+
+    for (;;) {
+        auto & f = stack.back();
+        int res;
+
+        auto end = _settled(f);
+        if (end > f.i) {
+            // Skip arguments that cannot be illogical,
+            // or all of them at once if nothing below is
+            if (!may_be_ill(f.op, lit_ill)) {
+                f.i = end;
+            }
+            else if (!may_be_ill(f.op->args[f.i].get(), lit_ill)) {
+                ++f.i;
+                continue;
+            }
+        }
+
+        if (f.i >= f.op->args.size()) {
+            res = _finish(f);
+        }
+        else {
+            auto arg = f.op->args[f.i].get();
+            if (IS_OP(arg)) {
+                auto search = memo.find(arg);
+                if (search == memo.end()) {
+                    stack.push_back(_frame(static_cast<Operator const *>(arg)));
+                    continue;
+                }
+                res = _step(f, search->second);
+            }
+            else {
+                res = _step(f, atom(arg));
+            }
+            if (res < 0) {
+                continue;
+            }
+        }
+
+        auto v = static_cast<value_t>(res);
+        if ((f.op->kind & 1) == 0) {
+            v = value_not(v);
+        }
+
+        memo.insert({f.op, v});
+        stack.pop_back();
+        if (stack.empty()) {
+            return v;
+        }
+    }
+}
+
+
+const_t
+BoolExpr::eval(point_t const & point) const
+{
+    auto leaf = [&point] (Literal const * lit) {
+        auto x = static_pointer_cast<Variable const>(abs(lit_t(lit)));
+        auto search = point.find(x);
+        if (search == point.end()) {
+            return BoolExpr::LOG;
+        }
+        auto v = search->second->kind;
+        return IS_VAR(lit) ? v : value_not(v);
+    };
+
+    auto lit_ill = false;
+    for (auto const & xv : point) {
+        lit_ill |= IS_ILL(xv.second);
+    }
+
+    return value_const(_eval(this, leaf, lit_ill));
+}
+
+
+const_t
+BoolExpr::eval(Context const * ctx, vector<bool> const & bits) const
+{
+    auto leaf = [ctx, &bits] (Literal const * lit) {
+        auto i = lit->id >> 1;
+        if (lit->ctx != ctx || i >= bits.size()) {
+            return BoolExpr::LOG;
+        }
+        // Variables have odd ids, and complements even ones
+        return static_cast<value_t>(bits[i] == static_cast<bool>(lit->id & 1));
+    };
+
+    return value_const(_eval(this, leaf, false));
+}
+
+
+}  // namespace boolexpr
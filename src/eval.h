@@ -0,0 +1,66 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// WARNING:
+//     The contents of this file are implementation details.
+//     Do not use these declarations for anything,
+//     because they may change without notice.
+
+
+namespace boolexpr {
+
+
+// Values are the constant kinds: ZERO, ONE, LOG, and ILL.
+using value_t = BoolExpr::Kind;
+
+
+// Return the value of ~v, where ~X is X, and ~? is ?
+inline value_t
+value_not(value_t v)
+{
+    return (v >> 2 == 0) ? static_cast<value_t>(v ^ 1) : v;
+}
+
+
+// Return the constant node of a value
+inline const_t
+value_const(value_t v)
+{
+    switch (v) {
+        case BoolExpr::ZERO:
+            return zero();
+        case BoolExpr::ONE:
+            return one();
+        case BoolExpr::LOG:
+            return logical();
+        default:
+            return illogical();
+    }
+}
+
+
+// Return true if bx can evaluate or restrict to illogical.
+// lit_ill says whether a literal can, which depends on the point.
+inline bool
+may_be_ill(BoolExpr const * bx, bool lit_ill)
+{
+    if (IS_OP(bx)) {
+        return lit_ill || static_cast<Operator const *>(bx)->has_ill();
+    }
+    return IS_LIT(bx) ? lit_ill : IS_ILL(bx);
+}
+
+
+} // namespace boolexpr
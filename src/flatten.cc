@@ -14,43 +14,32 @@
 
 
 #include <cassert>
+#include <memory>
 #include <set>
 
 #include "boolexpr/boolexpr.h"
+#include "rewrite.h"
 
 
+using boost::static_pointer_cast;
 using std::set;
-using std::static_pointer_cast;
 using std::vector;
 
 
 namespace boolexpr {
 
 
-static vector<set<lit_t>>
-_twolvl2clauses(lop_t const & lop)
+// Order literals by id, so _lits_cmp can compare clauses with a merge.
+struct LitLess
 {
-    vector<set<lit_t>> clauses;
-
-    for (bx_t const & arg : lop->args) {
-        set<lit_t> clause;
-        if (IS_LIT(arg)) {
-            clause.insert(static_pointer_cast<Literal const>(arg));
-        }
-        else if (IS_OP(arg)) {
-            auto op = static_pointer_cast<Operator const>(arg);
-            for (bx_t const & subarg : op->args) {
-                clause.insert(static_pointer_cast<Literal const>(subarg));
-            }
-        }
-        else {
-            assert(false);
-        }
-        clauses.push_back(std::move(clause));
+    bool operator()(lit_t const & x, lit_t const & y) const
+    {
+        return x->id < y->id;
     }
+};
 
-    return std::move(clauses);
-}
+
+using clause_t = set<lit_t, LitLess>;
 
 
 // Return a byte that shows set membership.
@@ -63,7 +52,7 @@ _twolvl2clauses(lop_t const & lop)
 #define YS_LTE_XS (1u << 1)
 
 static uint8_t
-_lits_cmp(set<lit_t> const & xs, set<lit_t> const & ys)
+_lits_cmp(clause_t const & xs, clause_t const & ys)
 {
     uint8_t ret = XS_LTE_YS | YS_LTE_XS;
 
@@ -102,8 +91,8 @@ _lits_cmp(set<lit_t> const & xs, set<lit_t> const & ys)
 }
 
 
-static vector<set<lit_t>>
-_absorb(vector<set<lit_t>> const && clauses)
+static vector<clause_t>
+_absorb(vector<clause_t> const && clauses)
 {
     if (clauses.size() == 0) {
         return std::move(clauses);
@@ -138,7 +127,7 @@ _absorb(vector<set<lit_t>> const && clauses)
         return std::move(clauses);
     }
 
-    vector<set<lit_t>> kept_clauses;
+    vector<clause_t> kept_clauses;
     for (size_t i = 0; i < clauses.size(); ++i) {
         if (keep[i]) {
             kept_clauses.push_back(clauses[i]);
@@ -149,202 +138,102 @@ _absorb(vector<set<lit_t>> const && clauses)
 }
 
 
-// NOTE: Return size is MxN
-static vector<set<lit_t>>
-_product(vector<set<lit_t>> const & clauses)
+// Return true if clause y has the complement of a literal in clause x
+static bool
+_complements(clause_t const & x, clause_t const & y)
 {
-    vector<set<lit_t>> product {{}};
-
-    for (auto const & clause : clauses) {
-        vector<set<lit_t>> newprod;
-        for (auto const & factor : product) {
-            for (lit_t const & x : clause) {
-                auto xn = static_pointer_cast<Literal const>(~x);
-                if (factor.find(xn) == factor.end()) {
-                    newprod.push_back(factor);
-                    newprod.back().insert(x);
-                }
-            }
+    for (lit_t const & lit : y) {
+        if (x.find(static_pointer_cast<Literal const>(~lit)) != x.end()) {
+            return true;
         }
-        product = _absorb(std::move(newprod));
-    }
-
-    return std::move(product);
-}
-
-
-bx_t
-Atom::to_cnf() const
-{
-    return shared_from_this();
-}
-
-
-bx_t
-Nor::to_cnf() const
-{
-    return to_posop()->to_cnf();
-}
-
-
-bx_t
-Or::to_cnf() const
-{
-    auto or_or_and = transform([](bx_t const & arg){return arg->to_dnf();});
-    auto bx = or_or_and->simplify();
-
-    if (IS_ATOM(bx)) {
-        return bx;
-    }
-
-    auto lop = static_pointer_cast<LatticeOperator const>(bx);
-
-    if (lop->is_clause()) {
-        return lop;
     }
-
-    auto clauses = _product(_absorb(_twolvl2clauses(lop)));
-
-    vector<bx_t> args;
-    for (auto const & clause : clauses) {
-        args.push_back(or_s(vector<bx_t>(clause.cbegin(), clause.cend())));
-    }
-    return and_s(std::move(args));
+    return false;
 }
 
 
-bx_t
-Nand::to_cnf() const
-{
-    return to_posop()->to_cnf();
-}
+// Clauses are shared by every node that uses them
+using clauses_t = std::shared_ptr<vector<clause_t> const>;
 
 
-bx_t
-And::to_cnf() const
+// Return the clauses of an NNF node in two-level form,
+// from the clauses of its arguments.
+// Arguments of the outer kind contribute their clauses as is.
+// Otherwise, the clauses of the arguments multiply out,
+// and clauses with both x and ~x drop out.
+// NOTE: Return size is the product of the argument sizes.
+static clauses_t
+_twolvl(BoolExpr::Kind outer, bx_t const & bx, vector<clauses_t> const & args)
 {
-    auto and_and_or = transform([](bx_t const & arg){return arg->to_cnf();});
-    auto bx = and_and_or->simplify();
+    vector<clause_t> clauses;
 
-    if (IS_ATOM(bx)) {
-        return bx;
+    if (IS_LIT(bx)) {
+        clauses.push_back({static_pointer_cast<Literal const>(bx)});
     }
-
-    auto lop = static_pointer_cast<LatticeOperator const>(bx);
-
-    if (lop->is_clause()) {
-        return lop;
-    }
-
-    auto clauses = _absorb(_twolvl2clauses(lop));
-
-    vector<bx_t> args;
-    for (auto const & clause : clauses) {
-        args.push_back(or_s(vector<bx_t>(clause.cbegin(), clause.cend())));
+    else if (bx->kind == outer) {
+        for (auto const & arg : args) {
+            clauses.insert(clauses.end(), arg->cbegin(), arg->cend());
+        }
     }
-    return and_s(std::move(args));
-}
-
-
-bx_t
-Xnor::to_cnf() const
-{
-    return to_posop()->to_cnf();
-}
-
-
-bx_t
-Xor::to_cnf() const
-{
-    size_t n = args.size();
-
-    vector<bx_t> clauses;
-    for (auto it = space_iter(n); it != space_iter(); ++it) {
-        if (!it.parity()) {
-            vector<bx_t> clause(n);
-            for (size_t i = 0; i < n; ++i) {
-                clause[i] = (*it)[i] ? ~args[i] : args[i];
+    else {
+        assert(IS_OP(bx));
+
+        clauses.push_back({});
+        for (auto const & arg : args) {
+            vector<clause_t> product;
+            for (auto const & factor : clauses) {
+                for (auto const & clause : *arg) {
+                    if (!_complements(factor, clause)) {
+                        product.push_back(factor);
+                        product.back().insert(clause.cbegin(), clause.cend());
+                    }
+                }
             }
-            clauses.push_back(or_(std::move(clause)));
+            clauses = _absorb(std::move(product));
         }
     }
 
-    return and_(std::move(clauses))->to_cnf();
+    return std::make_shared<vector<clause_t> const>(_absorb(std::move(clauses)));
 }
 
 
-bx_t
-Unequal::to_cnf() const
+// Convert to an NNF of Or and And,
+// then flatten it bottom-up, once per unique node.
+static bx_t
+_to_twolvl(BoolExpr const * self, BoolExpr::Kind outer)
 {
-    size_t n = args.size();
+    auto nnf = self->to_nnf();
 
-    vector<bx_t> xs(n), xns(n);
-    for (size_t i = 0; i < n; ++i) {
-        xns[i] = ~args[i];
-        xs[i] = args[i];
+    if (IS_ATOM(nnf)) {
+        return nnf;
     }
 
-    return (or_(std::move(xns)) & or_(std::move(xs)))->to_cnf();
-}
+    auto f = [outer] (bx_t const & bx, vector<clauses_t> const & args) {
+        return _twolvl(outer, bx, args);
+    };
+    auto clauses = postorder<clauses_t>(nnf, f);
 
+    bool cnf = (outer == BoolExpr::AND);
 
-bx_t
-Equal::to_cnf() const
-{
-    size_t n = args.size();
-    vector<bx_t> terms(n * (n-1));
-
-    size_t cnt = 0;
-    for (size_t i = 0; i < (n-1); ++i) {
-        for (size_t j = i+1; j < n; ++j) {
-            terms[cnt++] = ~args[i] | args[j];
-            terms[cnt++] = args[i] | ~args[j];
-        }
+    vector<bx_t> args;
+    for (auto const & clause : *clauses) {
+        vector<bx_t> lits(clause.cbegin(), clause.cend());
+        args.push_back(cnf ? or_s(std::move(lits)) : and_s(std::move(lits)));
     }
-
-    return and_(std::move(terms))->to_cnf();
-}
-
-
-bx_t
-NotImplies::to_cnf() const
-{
-    auto p = args[0];
-    auto q = args[1];
-
-    return (p & ~q)->to_cnf();
-}
-
-
-bx_t
-Implies::to_cnf() const
-{
-    auto p = args[0];
-    auto q = args[1];
-
-    return (~p | q)->to_cnf();
+    return cnf ? and_s(std::move(args)) : or_s(std::move(args));
 }
 
 
 bx_t
-NotIfThenElse::to_cnf() const
+Atom::to_cnf() const
 {
-    auto s = args[0];
-    auto d1 = args[1];
-    auto d0 = args[2];
-
-    return ((~s | ~d1) & (s | ~d0))->to_cnf();
+    return shared_from_this();
 }
 
 
 bx_t
-IfThenElse::to_cnf() const
+Operator::to_cnf() const
 {
-    auto s = args[0];
-    auto d1 = args[1];
-    auto d0 = args[2];
-
-    return ((~s | d1) & (s | d0))->to_cnf();
+    return _to_twolvl(this, AND);
 }
 
 
@@ -356,170 +245,9 @@ Atom::to_dnf() const
 
 
 bx_t
-Nor::to_dnf() const
+Operator::to_dnf() const
 {
-    return to_posop()->to_dnf();
-}
-
-
-bx_t
-Or::to_dnf() const
-{
-    auto or_or_and = transform([](bx_t const & arg){return arg->to_dnf();});
-    auto bx = or_or_and->simplify();
-
-    if (IS_ATOM(bx)) {
-        return bx;
-    }
-
-    auto lop = static_pointer_cast<LatticeOperator const>(bx);
-
-    if (lop->is_clause()) {
-        return lop;
-    }
-
-    auto clauses = _absorb(_twolvl2clauses(lop));
-
-    vector<bx_t> args;
-    for (auto const & clause : clauses) {
-        args.push_back(and_s(vector<bx_t>(clause.cbegin(), clause.cend())));
-    }
-    return or_s(std::move(args));
-}
-
-
-bx_t
-Nand::to_dnf() const
-{
-    return to_posop()->to_dnf();
-}
-
-
-bx_t
-And::to_dnf() const
-{
-    auto and_and_or = transform([](bx_t const & arg){return arg->to_dnf();});
-    auto bx = and_and_or->simplify();
-
-    if (IS_ATOM(bx)) {
-        return bx;
-    }
-
-    auto lop = static_pointer_cast<LatticeOperator const>(bx);
-
-    if (lop->is_clause()) {
-        return lop;
-    }
-
-    auto clauses = _product(_absorb(_twolvl2clauses(lop)));
-
-    vector<bx_t> args;
-    for (auto const & clause : clauses) {
-        args.push_back(and_s(vector<bx_t>(clause.cbegin(), clause.cend())));
-    }
-    return or_s(std::move(args));
-}
-
-
-bx_t
-Xnor::to_dnf() const
-{
-    return to_posop()->to_dnf();
-}
-
-
-bx_t
-Xor::to_dnf() const
-{
-    size_t n = args.size();
-
-    vector<bx_t> clauses;
-    for (auto it = space_iter(n); it != space_iter(); ++it) {
-        if (it.parity()) {
-            vector<bx_t> clause(n);
-            for (size_t i = 0; i < n; ++i) {
-                clause[i] = (*it)[i] ? args[i] : ~args[i];
-            }
-            clauses.push_back(and_(std::move(clause)));
-        }
-    }
-
-    return or_(std::move(clauses))->to_dnf();
-}
-
-
-bx_t
-Unequal::to_dnf() const
-{
-    size_t n = args.size();
-    vector<bx_t> terms(n * (n-1));
-
-    size_t cnt = 0;
-    for (size_t i = 0; i < (n-1); ++i) {
-        for (size_t j = i+1; j < n; ++j) {
-            terms[cnt++] = ~args[i] & args[j];
-            terms[cnt++] = args[i] & ~args[j];
-        }
-    }
-
-    return or_(std::move(terms))->to_dnf();
-}
-
-
-bx_t
-Equal::to_dnf() const
-{
-    size_t n = args.size();
-
-    vector<bx_t> xs(n), xns(n);
-    for (size_t i = 0; i < n; ++i) {
-        xns[i] = ~args[i];
-        xs[i] = args[i];
-    }
-
-    return (and_(std::move(xns)) | and_(std::move(xs)))->to_dnf();
-}
-
-
-bx_t
-NotImplies::to_dnf() const
-{
-    auto p = args[0];
-    auto q = args[1];
-
-    return (p & ~q)->to_dnf();
-}
-
-
-bx_t
-Implies::to_dnf() const
-{
-    auto p = args[0];
-    auto q = args[1];
-
-    return (~p | q)->to_dnf();
-}
-
-
-bx_t
-NotIfThenElse::to_dnf() const
-{
-    auto s = args[0];
-    auto d1 = args[1];
-    auto d0 = args[2];
-
-    return ((s & ~d1) | (~s & ~d0))->to_dnf();
-}
-
-
-bx_t
-IfThenElse::to_dnf() const
-{
-    auto s = args[0];
-    auto d1 = args[1];
-    auto d0 = args[2];
-
-    return ((s & d1) | (~s & d0))->to_dnf();
+    return _to_twolvl(this, OR);
 }
 
 
@@ -14,9 +14,7 @@
 
 
 #include "boolexpr/boolexpr.h"
-
-
-using std::make_shared;
+#include "unique.h"
 
 
 namespace boolexpr {
@@ -67,84 +65,84 @@ Variable::invert() const
 bx_t
 Nor::invert() const
 {
-    return make_shared<Or>(simple, args);
+    return make_op(OR, simple, args);
 }
 
 
 bx_t
 Or::invert() const
 {
-    return make_shared<Nor>(simple, args);
+    return make_op(NOR, simple, args);
 }
 
 
 bx_t
 Nand::invert() const
 {
-    return make_shared<And>(simple, args);
+    return make_op(AND, simple, args);
 }
 
 
 bx_t
 And::invert() const
 {
-    return make_shared<Nand>(simple, args);
+    return make_op(NAND, simple, args);
 }
 
 
 bx_t
 Xnor::invert() const
 {
-    return make_shared<Xor>(simple, args);
+    return make_op(XOR, simple, args);
 }
 
 
 bx_t
 Xor::invert() const
 {
-    return make_shared<Xnor>(simple, args);
+    return make_op(XNOR, simple, args);
 }
 
 
 bx_t
 Unequal::invert() const
 {
-    return make_shared<Equal>(simple, args);
+    return make_op(EQ, simple, args);
 }
 
 
 bx_t
 Equal::invert() const
 {
-    return make_shared<Unequal>(simple, args);
+    return make_op(NEQ, simple, args);
 }
 
 
 bx_t
 NotImplies::invert() const
 {
-    return make_shared<Implies>(simple, args[0], args[1]);
+    return make_op(IMPL, simple, {args[0], args[1]});
 }
 
 
 bx_t
 Implies::invert() const
 {
-    return make_shared<NotImplies>(simple, args[0], args[1]);
+    return make_op(NIMPL, simple, {args[0], args[1]});
 }
 
 
 bx_t
 NotIfThenElse::invert() const
 {
-    return make_shared<IfThenElse>(simple, args[0], args[1], args[2]);
+    return make_op(ITE, simple, {args[0], args[1], args[2]});
 }
 
 
 bx_t
 IfThenElse::invert() const
 {
-    return make_shared<NotIfThenElse>(simple, args[0], args[1], args[2]);
+    return make_op(NITE, simple, {args[0], args[1], args[2]});
 }
 
 
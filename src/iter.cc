@@ -13,10 +13,12 @@
 // limitations under the License.
 
 
+#include <algorithm>
+
 #include "boolexpr/boolexpr.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::vector;
 
 
@@ -293,8 +295,7 @@ domain_iter::domain_iter()
 
 
 domain_iter::domain_iter(bx_t const & f)
-    : s {f->support()}
-    , it {vector<var_t>(s.begin(), s.end())}
+    : it {vector<var_t>(f->support_vars().begin(), f->support_vars().end())}
 {}
 
 
@@ -328,15 +329,64 @@ domain_iter::operator++()
 
 
 cf_iter::cf_iter()
-    : it {points_iter()}
+    : it {space_iter()}
+    , ctx {nullptr}
 {}
 
 
 cf_iter::cf_iter(bx_t const & f, vector<var_t> const & vars)
     : f {f}
-    , it {points_iter(vars)}
-    , cf {f->restrict_(*it)}
-{}
+    , vars {vars}
+    , it {space_iter(vars.size())}
+    , ctx {vars.empty() ? nullptr : vars[0]->ctx}
+{
+    for (var_t const & x : vars) {
+        if (x->ctx != ctx) {
+            ctx = nullptr;
+            break;
+        }
+        point.resize(std::max(point.size(), size_t((x->id >> 1) + 1)));
+    }
+
+    restrict_();
+}
+
+
+static const_t
+_const(bool bit)
+{
+    if (bit) {
+        return one();
+    }
+    return zero();
+}
+
+
+// Variables from one context set the dense point from the counter bits,
+// and skip building a hashed point.
+void
+cf_iter::restrict_()
+{
+    if (it == space_iter()) {
+        return;
+    }
+
+    auto const & bits = *it;
+
+    if (ctx == nullptr) {
+        point_t p;
+        for (size_t i = 0; i < vars.size(); ++i) {
+            p.insert({vars[i], _const(bits[i])});
+        }
+        cf = f->restrict_(p);
+        return;
+    }
+
+    for (size_t i = 0; i < vars.size(); ++i) {
+        point[vars[i]->id >> 1] = _const(bits[i]);
+    }
+    cf = f->restrict_dense(ctx, point);
+}
 
 
 bool
@@ -364,7 +414,7 @@ cf_iter const &
 cf_iter::operator++()
 {
     ++it;
-    cf = f->restrict_(*it);
+    restrict_();
     return *this;
 }
 
@@ -14,6 +14,7 @@
 
 
 #include "boolexpr/boolexpr.h"
+#include "rewrite.h"
 
 
 using std::vector;
@@ -29,126 +30,91 @@ Atom::to_latop() const
 }
 
 
-bx_t
-LatticeOperator::to_latop() const
-{
-    return transform([](bx_t const & arg){return arg->to_latop();});
-}
-
-
+// x0 ^ x1 <=> ~x0 & x1 | x0 & ~x1
 static bx_t
-_nop_to_latop(BoolExpr const * const bx)
-{
-    auto op = ~bx->shared_from_this();
-    return ~op->to_latop();
-}
-
-bx_t
-Nor::to_latop() const
+_xor2(bx_t const & x0, bx_t const & x1)
 {
-    return _nop_to_latop(this);
+    return (~x0 & x1) | (x0 & ~x1);
 }
 
 
-bx_t
-Nand::to_latop() const
-{
-    return _nop_to_latop(this);
-}
-
-
-bx_t
-Xnor::to_latop() const
-{
-    return _nop_to_latop(this);
-}
-
-
-bx_t
-Unequal::to_latop() const
+// x0 ^ x1 ^ x2 ^ x3 <=> (x0 ^ x1) ^ (x2 ^ x3)
+static bx_t
+_xor_latop(bx_t const * args, size_t n)
 {
-    return _nop_to_latop(this);
-}
-
+    if (n == 1) {
+        return args[0];
+    }
 
-bx_t
-NotImplies::to_latop() const
-{
-    return _nop_to_latop(this);
-}
+    if (n == 2) {
+        return _xor2(args[0], args[1]);
+    }
 
+    size_t const mid = n / 2;
 
-bx_t
-NotIfThenElse::to_latop() const
-{
-    return _nop_to_latop(this);
+    return _xor2(_xor_latop(args, mid), _xor_latop(args + mid, n - mid));
 }
 
 
-bx_t
-Xor::to_latop() const
+// Lattice form of a positive operator, given its arguments in lattice form
+static bx_t
+_latop(BoolExpr::Kind kind, vector<bx_t> const & args)
 {
-    if (args.size() == 0) {      // LCOV_EXCL_LINE
-        return Xor::identity();  // LCOV_EXCL_LINE
-    }                            // LCOV_EXCL_LINE
-
-    if (args.size() == 1) {          // LCOV_EXCL_LINE
-        return args[0]->to_latop();  // LCOV_EXCL_LINE
-    }                                // LCOV_EXCL_LINE
-
-    if (args.size() == 2) {
-        // x0 ^ x1 <=> ~x0 & x1 | x0 & ~x1
-        auto x0 = args[0]->to_latop();
-        auto x1 = args[1]->to_latop();
-        return (~x0 & x1) | (x0 & ~x1);
+    switch (kind) {
+        case BoolExpr::XOR:
+            if (args.size() == 0) {      // LCOV_EXCL_LINE
+                return Xor::identity();  // LCOV_EXCL_LINE
+            }                            // LCOV_EXCL_LINE
+            return _xor_latop(args.data(), args.size());
+
+        case BoolExpr::EQ: {
+            // eq(x0, x1, x2) <=> ~x0 & ~x1 & ~x2 | x0 & x1 & x2
+            vector<bx_t> xns(args.size());
+            for (size_t i = 0 ; i < args.size(); ++i) {
+                xns[i] = ~args[i];
+            }
+            return and_(std::move(xns)) | and_(args);
+        }
+
+        case BoolExpr::IMPL:
+            return ~args[0] | args[1];
+
+        // IfThenElse
+        default:
+            return (args[0] & args[1]) | (~args[0] & args[2]);
     }
-
-    // x0 ^ x1 ^ x2 ^ x3 <=> (x0 ^ x1) ^ (x2 ^ x3)
-    size_t const mid = args.size() / 2;
-
-    auto lo = xor_(vector<bx_t>(args.cbegin(), args.cbegin() + mid));
-    auto hi = xor_(vector<bx_t>(args.cbegin() + mid, args.cend()));
-
-    return (lo ^ hi)->to_latop();
 }
 
 
-bx_t
-Equal::to_latop() const
+static bx_t
+_to_latop(bx_t const & bx, vector<bx_t> const & args)
 {
-    size_t n = args.size();
-
-    // eq(x0, x1, x2) <=> ~x0 & ~x1 & ~x2 | x0 & x1 & x2
-    vector<bx_t> xs(n), xns(n);
-
-    for (size_t i = 0 ; i < n; ++i) {
-        auto x = args[i]->to_latop();
-        xs[i] = x;
-        xns[i] = ~x;
+    if (IS_ATOM(bx)) {
+        return bx;
     }
 
-    return and_(std::move(xns)) | and_(std::move(xs));
-}
+    auto op = static_cast<Operator const *>(bx.get());
 
+    // Or, Nor, And, Nand are already lattice operators
+    if ((op->kind & 0x1C) == 0x10) {
+        return with_args(op, args);
+    }
 
-bx_t
-Implies::to_latop() const
-{
-    auto p = args[0]->to_latop();
-    auto q = args[1]->to_latop();
+    // Positive kinds have the lowest bit set
+    if (op->kind & 1) {
+        return _latop(op->kind, args);
+    }
 
-    return ~p | q;
+    // ~f(x0, x1, ...) <=> ~(f(x0, x1, ...))
+    auto kind = static_cast<BoolExpr::Kind>(op->kind | 1);
+    return ~_latop(kind, args);
 }
 
 
 bx_t
-IfThenElse::to_latop() const
+Operator::to_latop() const
 {
-    auto s = args[0]->to_latop();
-    auto d1 = args[1]->to_latop();
-    auto d0 = args[2]->to_latop();
-
-    return (s & d1) | (~s & d0);
+    return postorder_rewrite(shared_from_this(), _to_latop);
 }
 
 
@@ -14,11 +14,11 @@
 
 
 #include "boolexpr/boolexpr.h"
+#include "unique.h"
 
 
+using boost::static_pointer_cast;
 using std::initializer_list;
-using std::make_shared;
-using std::static_pointer_cast;
 using std::vector;
 
 
@@ -53,7 +53,7 @@ or_(vector<bx_t> const & args)
         return *args.cbegin();
     }
     else {
-        return make_shared<Or>(false, args);
+        return make_op(BoolExpr::OR, false, args);
     }
 }
 
@@ -68,7 +68,7 @@ or_(vector<bx_t> const && args)
         return *args.cbegin();
     }
     else {
-        return make_shared<Or>(false, args);
+        return make_op(BoolExpr::OR, false, args);
     }
 }
 
@@ -111,7 +111,7 @@ and_(vector<bx_t> const & args)
         return *args.cbegin();
     }
     else {
-        return make_shared<And>(false, args);
+        return make_op(BoolExpr::AND, false, args);
     }
 }
 
@@ -126,7 +126,7 @@ and_(vector<bx_t> const && args)
         return *args.cbegin();
     }
     else {
-        return make_shared<And>(false, args);
+        return make_op(BoolExpr::AND, false, args);
     }
 }
 
@@ -169,7 +169,7 @@ xor_(vector<bx_t> const & args)
         return *args.cbegin();
     }
     else {
-        return make_shared<Xor>(false, args);
+        return make_op(BoolExpr::XOR, false, args);
     }
 }
 
@@ -184,7 +184,7 @@ xor_(vector<bx_t> const && args)
         return *args.cbegin();
     }
     else {
-        return make_shared<Xor>(false, args);
+        return make_op(BoolExpr::XOR, false, args);
     }
 }
 
@@ -224,7 +224,7 @@ eq(vector<bx_t> const & args)
         return one();
     }
     else {
-        return make_shared<Equal>(false, args);
+        return make_op(BoolExpr::EQ, false, args);
     }
 }
 
@@ -236,7 +236,7 @@ eq(vector<bx_t> const && args)
         return one();
     }
     else {
-        return make_shared<Equal>(false, args);
+        return make_op(BoolExpr::EQ, false, args);
     }
 }
 
@@ -251,28 +251,28 @@ eq(initializer_list<bx_t> const args)
 bx_t
 nimpl(bx_t const & p, bx_t const & q)
 {
-    return make_shared<NotImplies>(false, p, q);
+    return make_op(BoolExpr::NIMPL, false, {p, q});
 }
 
 
 bx_t
 impl(bx_t const & p, bx_t const & q)
 {
-    return make_shared<Implies>(false, p, q);
+    return make_op(BoolExpr::IMPL, false, {p, q});
 }
 
 
 bx_t
 nite(bx_t const & s, bx_t const & d1, bx_t const & d0)
 {
-    return make_shared<NotIfThenElse>(false, s, d1, d0);
+    return make_op(BoolExpr::NITE, false, {s, d1, d0});
 }
 
 
 bx_t
 ite(bx_t const & s, bx_t const & d1, bx_t const & d0)
 {
-    return make_shared<IfThenElse>(false, s, d1, d0);
+    return make_op(BoolExpr::ITE, false, {s, d1, d0});
 }
 
 
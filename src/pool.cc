@@ -0,0 +1,438 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "boolexpr/boolexpr.h"
+#include "pool.h"
+
+
+namespace boolexpr {
+
+
+static thread_local NodePool * _current_pool = nullptr;
+
+
+Arena::Arena()
+    : next {nullptr}
+    , end {nullptr}
+    , free_lists {}
+    , live {0}
+    , orphaned {false}
+{}
+
+
+Arena::~Arena()
+{
+    for (char * chunk : chunks) {
+        ::operator delete(chunk);
+    }
+}
+
+
+void
+Arena::grow()
+{
+    auto chunk = static_cast<char *>(::operator new(CHUNK_SIZE));
+    chunks.push_back(chunk);
+    next = chunk;
+    end = chunk + CHUNK_SIZE;
+}
+
+
+void *
+Arena::allocate(size_t n)
+{
+    ++live;
+
+    n += sizeof(Header);
+
+    Header * header;
+
+    if (n > MAX_SIZE) {
+        header = static_cast<Header *>(::operator new(n));
+    }
+    else {
+        size_t index = (n - 1) / ALIGN;
+
+        auto block = free_lists[index];
+        if (block != nullptr) {
+            free_lists[index] = block->next;
+            header = reinterpret_cast<Header *>(block);
+        }
+        else {
+            size_t size = (index + 1) * ALIGN;
+            if (next == nullptr || static_cast<size_t>(end - next) < size) {
+                grow();
+            }
+            header = reinterpret_cast<Header *>(next);
+            next += size;
+        }
+    }
+
+    header->arena = this;
+    header->size = n;
+
+    return header + 1;
+}
+
+
+void
+Arena::deallocate(Header * header)
+{
+    size_t n = header->size;
+
+    if (n > MAX_SIZE) {
+        ::operator delete(header);
+    }
+    else {
+        size_t index = (n - 1) / ALIGN;
+        auto block = reinterpret_cast<Block *>(header);
+        block->next = free_lists[index];
+        free_lists[index] = block;
+    }
+
+    if (--live == 0 && orphaned) {
+        delete this;
+    }
+}
+
+
+void
+Arena::destroy(BoolExpr const * bx)
+{
+    auto header = reinterpret_cast<Header *>(const_cast<BoolExpr *>(bx)) - 1;
+    bx->~BoolExpr();
+    header->arena->deallocate(header);
+}
+
+
+size_t
+Arena::get_live() const
+{
+    return live;
+}
+
+
+size_t
+Arena::get_capacity() const
+{
+    return chunks.size() * CHUNK_SIZE;
+}
+
+
+void
+Arena::orphan()
+{
+    if (live == 0) {
+        delete this;
+    }
+    else {
+        orphaned = true;
+    }
+}
+
+
+Arena *
+current_arena()
+{
+    return (_current_pool == nullptr) ? nullptr : _current_pool->arena;
+}
+
+
+// While a thread is freeing nodes, the nodes released by their destructors
+// go onto this list, instead of being freed recursively.
+static thread_local std::vector<BoolExpr const *> * _worklist = nullptr;
+
+
+void
+BoolExpr::free_all(BoolExpr const * bx, std::vector<BoolExpr const *> * pooled)
+{
+    std::vector<BoolExpr const *> worklist {bx};
+    _worklist = &worklist;
+
+    while (!worklist.empty()) {
+        auto next = worklist.back();
+        worklist.pop_back();
+        if (next->pooled) {
+            if (pooled != nullptr) {
+                pooled->push_back(next);
+            }
+            else {
+                Arena::destroy(next);
+            }
+        }
+        else {
+            delete next;
+        }
+    }
+
+    _worklist = nullptr;
+}
+
+
+// Pooled nodes that the background thread found while freeing a tree.
+// Arenas are not thread safe, so they go back to the thread that dropped
+// the tree, to be freed there.
+struct Inbox
+{
+    std::mutex mutex;
+    std::vector<BoolExpr const *> nodes;
+    std::atomic<bool> full {false};
+
+    ~Inbox();
+};
+
+
+// Frees nodes on a background thread.
+// NOTE: Never destroyed, b/c nodes may outlive static destruction.
+class Reclaimer
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable idle;
+
+    std::vector<std::pair<BoolExpr const *, std::shared_ptr<Inbox>>> queue;
+    bool busy;
+
+    void run();
+
+public:
+    Reclaimer();
+
+    void push(BoolExpr const * bx, std::shared_ptr<Inbox> const & inbox);
+    void wait();
+
+    // Free the pooled nodes in an inbox on the calling thread
+    static void drain(Inbox & inbox);
+};
+
+
+// Freed when its thread exits.
+// If the background thread still holds it, that thread frees what is left,
+// since the thread that used the pool is gone.
+Inbox::~Inbox()
+{
+    Reclaimer::drain(*this);
+}
+
+
+Reclaimer::Reclaimer()
+    : busy {false}
+{
+    std::thread(&Reclaimer::run, this).detach();
+}
+
+
+void
+Reclaimer::run()
+{
+    std::vector<std::pair<BoolExpr const *, std::shared_ptr<Inbox>>> batch;
+    std::vector<BoolExpr const *> pooled;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this]{ return !queue.empty(); });
+            batch.swap(queue);
+            busy = true;
+        }
+
+        for (auto const & item : batch) {
+            BoolExpr::free_all(item.first, &pooled);
+            if (!pooled.empty()) {
+                auto & inbox = *item.second;
+                std::lock_guard<std::mutex> lock(inbox.mutex);
+                inbox.nodes.insert(inbox.nodes.end(),
+                                   pooled.cbegin(), pooled.cend());
+                inbox.full = true;
+                pooled.clear();
+            }
+        }
+        batch.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+        }
+        idle.notify_all();
+    }
+}
+
+
+void
+Reclaimer::push(BoolExpr const * bx, std::shared_ptr<Inbox> const & inbox)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back({bx, inbox});
+    }
+    ready.notify_one();
+}
+
+
+void
+Reclaimer::wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]{ return queue.empty() && !busy; });
+}
+
+
+void
+Reclaimer::drain(Inbox & inbox)
+{
+    if (!inbox.full.exchange(false)) {
+        return;
+    }
+
+    std::vector<BoolExpr const *> nodes;
+    {
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        nodes.swap(inbox.nodes);
+    }
+
+    for (auto bx : nodes) {
+        BoolExpr::free_all(bx);
+    }
+}
+
+
+static std::once_flag _reclaimer_once;
+static std::atomic<Reclaimer *> _reclaimer {nullptr};
+static std::atomic<bool> _background {false};
+
+// This thread's inbox.
+// Plain pointers, so nodes freed by static destructors
+// after the holder is gone still see a valid (null) value.
+static thread_local Inbox * _inbox = nullptr;
+static thread_local bool _exiting = false;
+
+
+// Lets go of this thread's inbox when the thread exits
+struct InboxHolder
+{
+    std::shared_ptr<Inbox> inbox;
+
+    ~InboxHolder()
+    {
+        _inbox = nullptr;
+        _exiting = true;
+    }
+};
+
+
+static thread_local InboxHolder _holder;
+
+
+void
+BoolExpr::destroy(BoolExpr const * bx)
+{
+    if (_worklist != nullptr) {
+        _worklist->push_back(bx);
+        return;
+    }
+
+    if (_inbox != nullptr) {
+        Reclaimer::drain(*_inbox);
+    }
+
+    // Arenas are not thread safe, so pooled nodes are freed right here.
+    if (_background && !bx->pooled && !_exiting) {
+        if (_inbox == nullptr) {
+            _holder.inbox = std::make_shared<Inbox>();
+            _inbox = _holder.inbox.get();
+        }
+        _reclaimer.load()->push(bx, _holder.inbox);
+    }
+    else {
+        free_all(bx);
+    }
+}
+
+
+NodePool::NodePool()
+    : arena {new Arena()}
+{}
+
+
+NodePool::~NodePool()
+{
+    arena->orphan();
+}
+
+
+size_t
+NodePool::live() const
+{
+    return arena->get_live();
+}
+
+
+size_t
+NodePool::capacity() const
+{
+    return arena->get_capacity();
+}
+
+
+NodePoolScope::NodePoolScope(NodePool & pool)
+    : prev {_current_pool}
+{
+    _current_pool = &pool;
+}
+
+
+NodePoolScope::~NodePoolScope()
+{
+    _current_pool = prev;
+}
+
+
+bool
+background_destroy_enabled()
+{
+    return _background;
+}
+
+
+bool
+enable_background_destroy(bool enable)
+{
+    if (enable) {
+        std::call_once(_reclaimer_once, []{ _reclaimer = new Reclaimer(); });
+    }
+    return _background.exchange(enable);
+}
+
+
+void
+wait_background_destroy()
+{
+    auto reclaimer = _reclaimer.load();
+    if (reclaimer != nullptr) {
+        reclaimer->wait();
+    }
+    if (_inbox != nullptr) {
+        Reclaimer::drain(*_inbox);
+    }
+}
+
+
+}  // namespace boolexpr
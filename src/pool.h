@@ -0,0 +1,82 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// WARNING:
+//     The contents of this file are implementation details.
+//     Do not use these declarations for anything,
+//     because they may change without notice.
+
+
+namespace boolexpr {
+
+
+// Carves small blocks out of large chunks.
+// Freed blocks go onto a per-size free list.
+// Chunks are only returned to the system all at once,
+// after the owning NodePool is gone and the last block is freed.
+class Arena
+{
+    static size_t const CHUNK_SIZE = 64 * 1024;
+    static size_t const ALIGN = 16;
+    static size_t const MAX_SIZE = 256;
+
+    // Every block starts with a header that points back to its arena,
+    // so a node can be freed without knowing which pool it came from.
+    struct Header { Arena * arena; size_t size; };
+    struct Block { Block * next; };
+
+    std::vector<char *> chunks;
+    char * next;
+    char * end;
+
+    Block * free_lists[MAX_SIZE / ALIGN];
+
+    size_t live;
+    bool orphaned;
+
+    void grow();
+
+    void * allocate(size_t n);
+    void deallocate(Header * header);
+
+public:
+    Arena();
+    ~Arena();
+
+    // Construct a node in this arena
+    template <typename T, typename... Args>
+    T * create(Args const &... args)
+    {
+        auto bx = new (allocate(sizeof(T))) T(args...);
+        bx->pooled = true;
+        return bx;
+    }
+
+    // Destroy a node made by create, and return its block to the arena.
+    static void destroy(BoolExpr const * bx);
+
+    size_t get_live() const;
+    size_t get_capacity() const;
+
+    // Called by NodePool::~NodePool
+    void orphan();
+};
+
+
+// Return the arena of the innermost active NodePool, or nullptr.
+Arena * current_arena();
+
+
+} // namespace boolexpr
@@ -13,7 +13,10 @@
 // limitations under the License.
 
 
+#include <unordered_map>
+
 #include "boolexpr/boolexpr.h"
+#include "rewrite.h"
 
 
 using std::vector;
@@ -29,134 +32,140 @@ Atom::to_posop() const
 }
 
 
-bx_t
-Nor::to_posop() const
+// Whether argument i of an operator with (effective) kind K is negated
+static bool
+_neg_arg(BoolExpr::Kind kind, size_t i)
 {
-    // ~(x0 | x1 | ...) <=> ~x0 & ~x1 & ...
-    size_t n = args.size();
-    vector<bx_t> _args(n);
-
-    for (size_t i = 0; i < n; ++i) {
-        _args[i] = (~args[i])->to_posop();
+    switch (kind) {
+        // ~(x0 | x1 | ...) <=> ~x0 & ~x1 & ...
+        // ~(x0 & x1 & ...) <=> ~x0 | ~x1 | ...
+        case BoolExpr::NOR:
+        case BoolExpr::NAND:
+            return true;
+        // ~(x0 ^ x1 ^ x2 ^ ...) <=> ~x0 ^ x1 ^ x2 ^ ...
+        // ~eq(x0, x1, x2, ...) <=> eq(~x0, x1, x2, ...)
+        // p => q <=> ~p | q
+        case BoolExpr::XNOR:
+        case BoolExpr::NEQ:
+        case BoolExpr::IMPL:
+            return i == 0;
+        // ~(p => q) <=> p & ~q
+        case BoolExpr::NIMPL:
+            return i == 1;
+        // ~(s ? d1 : d0) <=> s ? ~d1 : ~d0
+        case BoolExpr::NITE:
+            return i != 0;
+        default:
+            return false;
     }
-
-    return and_(std::move(_args));
 }
 
 
-bx_t
-Or::to_posop() const
+// Positive form of op, or of its inverse if neg,
+// given the positive forms of its (possibly negated) arguments
+static bx_t
+_posop(Operator const * op, bool neg, vector<bx_t> const & args)
 {
-    return transform([](bx_t const & arg){return arg->to_posop();});
-}
-
-
-bx_t
-Nand::to_posop() const
-{
-    // ~(x0 & x1 & ...) <=> ~x0 | ~x1 | ...
-    size_t n = args.size();
-    vector<bx_t> _args(n);
-
-    for (size_t i = 0; i < n; ++i) {
-        _args[i] = (~args[i])->to_posop();
+    auto kind = static_cast<BoolExpr::Kind>(neg ? (op->kind ^ 1) : op->kind);
+
+    switch (kind) {
+        case BoolExpr::NOR:
+            return and_(args);
+        case BoolExpr::NAND:
+            return or_(args);
+        case BoolExpr::XNOR:
+            return xor_(args);
+        case BoolExpr::NEQ:
+            return eq(args);
+        case BoolExpr::NIMPL:
+            return args[0] & args[1];
+        case BoolExpr::IMPL:
+            return args[0] | args[1];
+        case BoolExpr::NITE:
+            return ite(args[0], args[1], args[2]);
+        // Already positive, so only the inverse of a negative form is new
+        case BoolExpr::OR:
+            return neg ? or_(args) : with_args(op, args);
+        case BoolExpr::AND:
+            return neg ? and_(args) : with_args(op, args);
+        case BoolExpr::XOR:
+            return neg ? xor_(args) : with_args(op, args);
+        case BoolExpr::EQ:
+            return neg ? eq(args) : with_args(op, args);
+        // IfThenElse
+        default:
+            return neg ? ite(args[0], args[1], args[2]) : with_args(op, args);
     }
-
-    return or_(std::move(_args));
 }
 
 
-bx_t
-And::to_posop() const
-{
-    return transform([](bx_t const & arg){return arg->to_posop();});
-}
+namespace {
 
+// A node, and whether we want the positive form of its inverse
+using posop_key_t = std::pair<BoolExpr const *, bool>;
 
-bx_t
-Xnor::to_posop() const
+struct PosopKeyHash
 {
-    // ~(x0 ^ x1 ^ x2 ^ ...) <=> ~x0 ^ x1 ^ x2 ^ ...
-    size_t n = args.size();
-    vector<bx_t> _args(n);
-
-    _args[0] = (~args[0])->to_posop();
-    for (size_t i = 1; i < n; ++i) {
-        _args[i] = args[i]->to_posop();
+    size_t operator()(posop_key_t const & p) const
+    {
+        return std::hash<BoolExpr const *>()(p.first) ^ p.second;
     }
+};
 
-    return xor_(std::move(_args));
-}
+}  // namespace
 
 
+// Only the polarities some parent asks for are built,
+// so a node that is never negated never gets an inverse form.
 bx_t
-Xor::to_posop() const
+Operator::to_posop() const
 {
-    return transform([](bx_t const & arg){return arg->to_posop();});
-}
-
-
-bx_t
-Unequal::to_posop() const
-{
-    // ~eq(x0, x1, x2, ...) <=> eq(~x0, x1, x2, ...)
-    size_t n = args.size();
-    vector<bx_t> _args(n);
-
-    _args[0] = (~args[0])->to_posop();
-    for (size_t i = 1; i < n; ++i) {
-        _args[i] = args[i]->to_posop();
+    std::unordered_map<posop_key_t, bx_t, PosopKeyHash> memo;
+
+    // Each frame is a key, and whether its arguments were pushed
+    vector<std::pair<posop_key_t, bool>> stack {{{this, false}, false}};
+
+    while (stack.size() > 0) {
+        auto key = stack.back().first;
+        if (memo.find(key) != memo.end()) {
+            stack.pop_back();
+            continue;
+        }
+
+        bx_t bx {key.first};
+        auto neg = key.second;
+        if (IS_ATOM(bx)) {
+            memo.emplace(key, neg ? ~bx : bx);
+            stack.pop_back();
+            continue;
+        }
+
+        auto op = static_cast<Operator const *>(key.first);
+        auto kind = static_cast<BoolExpr::Kind>(
+                        neg ? (op->kind ^ 1) : op->kind);
+        auto n = op->args.size();
+
+        if (!stack.back().second) {
+            stack.back().second = true;
+            for (size_t i = n; i-- > 0;) {
+                posop_key_t arg_key {op->args[i].get(), _neg_arg(kind, i)};
+                if (memo.find(arg_key) == memo.end()) {
+                    stack.push_back({arg_key, false});
+                }
+            }
+            continue;
+        }
+
+        vector<bx_t> args(n);
+        for (size_t i = 0; i < n; ++i) {
+            posop_key_t arg_key {op->args[i].get(), _neg_arg(kind, i)};
+            args[i] = memo.find(arg_key)->second;
+        }
+        memo.emplace(key, _posop(op, neg, args));
+        stack.pop_back();
     }
 
-    return eq(std::move(_args));
-}
-
-
-bx_t
-Equal::to_posop() const
-{
-    return transform([](bx_t const & arg){return arg->to_posop();});
-}
-
-
-bx_t
-NotImplies::to_posop() const
-{
-    // ~(p => q) <=> p & ~q
-    auto p = (args[0])->to_posop();
-    auto qn = (~args[1])->to_posop();
-
-    return p & qn;
-}
-
-
-bx_t
-Implies::to_posop() const
-{
-    // p => q <=> ~p | q
-    auto pn = (~args[0])->to_posop();
-    auto q = (args[1])->to_posop();
-
-    return pn | q;
-}
-
-
-bx_t
-IfThenElse::to_posop() const
-{
-    return transform([](bx_t const & arg){return arg->to_posop();});
-}
-
-
-bx_t
-NotIfThenElse::to_posop() const
-{
-    // ~(s ? d1 : d0) <=> s ? ~d1 : ~d0
-    auto s = (args[0])->to_posop();
-    auto d1n = (~args[1])->to_posop();
-    auto d0n = (~args[2])->to_posop();
-
-    return ite(s, d1n, d0n);
+    return memo.find({this, false})->second;
 }
 
 
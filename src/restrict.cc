@@ -13,10 +13,16 @@
 // limitations under the License.
 
 
+#include <cstdint>
+
 #include "boolexpr/boolexpr.h"
+#include "eval.h"
+#include "rewrite.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
+using std::unordered_map;
+using std::vector;
 
 
 namespace boolexpr {
@@ -49,11 +55,147 @@ Variable::restrict_(point_t const & point) const
 }
 
 
+// Return the value of an operator that is forced by argument i
+// restricting to the constant c, or nullptr if there is none.
+static bx_t
+_forced(BoolExpr::Kind kind, size_t i, bx_t const & c)
+{
+    switch (kind) {
+        case BoolExpr::NOR:
+            return IS_ONE(c) ? bx_t(zero()) : nullptr;
+        case BoolExpr::OR:
+            return IS_ONE(c) ? bx_t(one()) : nullptr;
+        case BoolExpr::NAND:
+            return IS_ZERO(c) ? bx_t(one()) : nullptr;
+        case BoolExpr::AND:
+            return IS_ZERO(c) ? bx_t(zero()) : nullptr;
+        // 0 => q <=> p => 1 <=> 1
+        case BoolExpr::NIMPL:
+            return (IS_ZERO(c) && i == 0) || (IS_ONE(c) && i == 1)
+                   ? bx_t(zero()) : nullptr;
+        case BoolExpr::IMPL:
+            return (IS_ZERO(c) && i == 0) || (IS_ONE(c) && i == 1)
+                   ? bx_t(one()) : nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+
+// Restrict the DAG under root, visiting each unique operator once.
+// leaf(bx) restricts an atom, and lit_ill says whether that can be illogical.
+// An illogical argument makes the operator illogical at once.
+// Otherwise, a value forced by one argument is kept until the other
+// arguments are checked for illogical, and used instead of simplify.
+// Arguments that cannot be illogical are not restricted at all.
+template <typename Leaf>
+static bx_t
+_restrict(Operator const * root, Leaf leaf, bool lit_ill)
+{
+    struct Frame {
+        Operator const * op;
+        vector<bx_t> args;
+        bx_t forced;
+    };
+
+    unordered_map<BoolExpr const *, bx_t> memo;
+    vector<Frame> stack {{root, {}, nullptr}};
+
+    for (;;) {
+        auto & frame = stack.back();
+        auto op = frame.op;
+        auto i = frame.args.size();
+        bx_t bx;
+
+        if (i == op->args.size()) {
+            bx = frame.forced ? frame.forced
+                              : with_args(op, frame.args)->simplify();
+        }
+        else if (frame.forced && !may_be_ill(op, lit_ill)) {
+            bx = frame.forced;
+        }
+        else if (frame.forced && !may_be_ill(op->args[i].get(), lit_ill)) {
+            // Only the count of arguments matters from here on
+            frame.args.push_back(op->args[i]);
+            continue;
+        }
+        else {
+            auto const & arg = op->args[i];
+            bx_t y;
+            if (IS_ATOM(arg)) {
+                y = leaf(arg);
+            }
+            else {
+                auto search = memo.find(arg.get());
+                if (search == memo.end()) {
+                    auto arg_op = static_cast<Operator const *>(arg.get());
+                    stack.push_back({arg_op, {}, nullptr});
+                    continue;
+                }
+                y = search->second;
+            }
+
+            if (IS_ILL(y)) {
+                bx = y;
+            }
+            else {
+                if (!frame.forced) {
+                    frame.forced = _forced(op->kind, i, y);
+                }
+                frame.args.push_back(std::move(y));
+                continue;
+            }
+        }
+
+        memo.insert({op, bx});
+        stack.pop_back();
+        if (stack.empty()) {
+            return bx;
+        }
+    }
+}
+
+
 bx_t
 Operator::restrict_(point_t const & point) const
 {
-    auto f = [&point] (bx_t const & bx) { return bx->restrict_(point); };
-    return transform(f)->simplify();
+    auto leaf = [&point] (bx_t const & bx) { return bx->restrict_(point); };
+
+    auto lit_ill = false;
+    for (auto const & xv : point) {
+        lit_ill |= IS_ILL(xv.second);
+    }
+
+    return _restrict(this, leaf, lit_ill);
+}
+
+
+bx_t
+BoolExpr::restrict_dense(Context const * ctx,
+                         dense_point_t const & point) const
+{
+    auto leaf = [ctx, &point] (bx_t const & bx) {
+        if (IS_LIT(bx)) {
+            auto lit = static_cast<Literal const *>(bx.get());
+            auto i = lit->id >> 1;
+            if (lit->ctx == ctx && i < point.size() && point[i]) {
+                return IS_VAR(bx) ? bx_t(point[i]) : ~point[i];
+            }
+        }
+        return bx;
+    };
+
+    auto self = shared_from_this();
+    if (IS_ATOM(self)) {
+        return leaf(self);
+    }
+
+    auto lit_ill = false;
+    for (auto const & c : point) {
+        lit_ill |= c && IS_ILL(c);
+    }
+
+    return _restrict(static_cast<Operator const *>(this), leaf, lit_ill);
 }
 
 
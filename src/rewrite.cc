@@ -0,0 +1,40 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+
+#include "boolexpr/boolexpr.h"
+#include "rewrite.h"
+#include "unique.h"
+
+
+using std::vector;
+
+
+namespace boolexpr {
+
+
+bx_t
+with_args(Operator const * op, vector<bx_t> const & args)
+{
+    if (std::equal(args.cbegin(), args.cend(), op->args.cbegin())) {
+        return op->shared_from_this();
+    }
+
+    return make_op(op->kind, false, args);
+}
+
+
+}  // namespace boolexpr
@@ -0,0 +1,71 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// WARNING:
+//     The contents of this file are implementation details.
+//     Do not use these declarations for anything,
+//     because they may change without notice.
+
+
+namespace boolexpr {
+
+
+// Compute a result for every node in the DAG under root, bottom-up,
+// without recursion, and return the result for root.
+// f(bx, args) builds a node's result from the node,
+// and the results of its arguments (empty for atoms).
+// dfs_iter visits every unique node once in post-order,
+// so each shared sub-expression is only visited once.
+template <typename T, typename F>
+T
+postorder(bx_t const & root, F f)
+{
+    std::unordered_map<BoolExpr const *, T> memo;
+    std::vector<T> args;
+
+    for (auto it = dfs_iter(root); it != dfs_iter(); ++it) {
+        auto const & bx = *it;
+
+        args.clear();
+        if (IS_OP(bx)) {
+            auto op = static_cast<Operator const *>(bx.get());
+            for (bx_t const & arg : op->args) {
+                args.push_back(memo.find(arg.get())->second);
+            }
+        }
+
+        memo.emplace(bx.get(), f(bx, args));
+    }
+
+    return memo.find(root.get())->second;
+}
+
+
+// Rewrite the DAG under root into a new DAG.
+// Shared sub-expressions stay shared in the result.
+template <typename F>
+bx_t
+postorder_rewrite(bx_t const & root, F f)
+{
+    return postorder<bx_t>(root, f);
+}
+
+
+// Return op if every argument is the same node as before,
+// otherwise a new operator of the same kind.
+bx_t with_args(Operator const * op, std::vector<bx_t> const & args);
+
+
+} // namespace boolexpr
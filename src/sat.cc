@@ -16,8 +16,8 @@
 #include "boolexpr/boolexpr.h"
 
 
+using boost::static_pointer_cast;
 using std::make_pair;
-using std::static_pointer_cast;
 using std::unordered_map;
 using std::vector;
 
@@ -34,11 +34,11 @@ encode_cmsat(std::unordered_map<uint32_t, var_t> & idx2var,
              CMSat::SATSolver & solver,
              bx_t bx)
 {
-    auto xs = bx->support();
+    auto const & xs = bx->support_vars();
     unordered_map<lit_t, uint32_t> lit2idx;
 
     uint32_t index = 0;
-    for (var_t const & x : xs) {
+    for (var_t const x : xs) {
         auto xn_lit = static_pointer_cast<Literal const>(~x);
         auto  x_lit = static_pointer_cast<Literal const>( x);
         lit2idx.insert({xn_lit, (index << 1) | 0u});
@@ -138,10 +138,16 @@ Variable::_sat() const
 soln_t
 Operator::_sat() const
 {
+    // Search the truth table of a small function
+    auto table = truth_table(shared_from_this());
+    if (table) {
+        return table->sat();
+    }
+
     std::unordered_map<uint32_t, var_t> idx2var;
     CMSat::SATSolver solver;
 
-    auto ctx = Context();
+    Context ctx;
     auto cnf = tseytin(ctx);
     encode_cmsat(idx2var, solver, cnf);
 
@@ -175,6 +181,7 @@ sat_iter::sat_iter()
 
 
 sat_iter::sat_iter(bx_t const & bx)
+    : ctx {std::make_shared<Context>()}
 {
     one_soln = false;
 
@@ -207,7 +214,7 @@ sat_iter::sat_iter(bx_t const & bx)
 
     // Operator
     auto op = static_pointer_cast<Operator const>(bx);
-    auto cnf = op->tseytin(ctx);
+    auto cnf = op->tseytin(*ctx);
     encode_cmsat(idx2var, solver, cnf);
 
     get_soln();
@@ -226,7 +233,7 @@ sat_iter::get_soln()
         vector<CMSat::Lit> clause;
         for (size_t i = 0; i < solver.nVars(); ++i) {
             auto x = idx2var.find(i)->second;
-            if (x->ctx != &ctx) {
+            if (x->ctx != ctx.get()) {
                 if (model[i] == l_False) {
                     point.insert({x, zero()});
                     clause.push_back(CMSat::Lit(i, false));
@@ -15,9 +15,7 @@
 
 #include "boolexpr/boolexpr.h"
 #include "argset.h"
-
-
-using std::make_shared;
+#include "unique.h"
 
 
 namespace boolexpr {
@@ -31,6 +29,47 @@ Atom::simplify() const
 }
 
 
+void
+Operator::_simplify_descendants() const
+{
+    // Operators that are neither simple nor already simplified
+    auto _pending = [](BoolExpr const * bx) {
+        if (!IS_OP(bx)) {
+            return false;
+        }
+        auto op = static_cast<Operator const *>(bx);
+        return !op->simple && op->simplified.load() == nullptr;
+    };
+
+    std::vector<std::pair<Operator const *, bool>> stack;
+
+    for (bx_t const & arg : args) {
+        if (_pending(arg.get())) {
+            stack.push_back({static_cast<Operator const *>(arg.get()), false});
+        }
+    }
+
+    while (!stack.empty()) {
+        auto op = stack.back().first;
+
+        if (stack.back().second || !_pending(op)) {
+            stack.pop_back();
+            if (_pending(op)) {
+                op->simplify();
+            }
+            continue;
+        }
+
+        stack.back().second = true;
+        for (bx_t const & arg : op->args) {
+            if (_pending(arg.get())) {
+                stack.push_back({static_cast<Operator const *>(arg.get()), false});
+            }
+        }
+    }
+}
+
+
 bx_t
 Operator::simplify() const
 {
@@ -38,7 +77,27 @@ Operator::simplify() const
         return shared_from_this();
     }
 
-    return _simplify();
+    // Shared sub-expressions are only simplified once
+    auto cached = simplified.load(std::memory_order_acquire);
+    if (cached != nullptr) {
+        return bx_t(cached);
+    }
+
+    // Simplify non-simple descendants bottom-up, so each _simplify below
+    // only has to look one level down, and deep DAGs don't overflow the stack.
+    _simplify_descendants();
+
+    auto bx = _simplify();
+
+    if (bx.get() != this) {
+        intrusive_ptr_add_ref(bx.get());
+    }
+    if (!simplified.compare_exchange_strong(cached, bx.get())
+            && bx.get() != this) {
+        intrusive_ptr_release(bx.get());
+    }
+
+    return bx;
 }
 
 
@@ -150,7 +209,7 @@ Implies::_simplify() const
         return q;
     }
 
-    return make_shared<Implies>(true, p, q);
+    return make_op(IMPL, true, {p, q});
 }
 
 
@@ -243,7 +302,7 @@ IfThenElse::_simplify() const
         return and_s({s, d1});
     }
 
-    return make_shared<IfThenElse>(true, s, d1, d0);
+    return make_op(ITE, true, {s, d1, d0});
 }
 
 
@@ -0,0 +1,437 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "boolexpr/boolexpr.h"
+
+
+using std::vector;
+
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BX_SIMD 1
+#endif
+
+
+namespace boolexpr {
+
+
+#ifdef BX_SIMD
+typedef uint64_t u64x4_t __attribute__((vector_size(32), may_alias));
+typedef uint64_t u64x8_t __attribute__((vector_size(64), may_alias));
+#endif
+
+
+// Run the instructions over blocks of words of type V.
+// Always inlined, so each caller below compiles it for its own target.
+template <typename V>
+static inline __attribute__((always_inline)) void
+_simulate(Tape::Instr const * instrs, size_t n,
+          uint32_t const * operands, V * slots)
+{
+    V const zeros = V();
+    V const ones = ~zeros;
+
+    for (size_t j = 0; j < n; ++j) {
+        auto const & instr = instrs[j];
+        auto args = operands + instr.first;
+        V y;
+
+        switch (instr.kind) {
+            case BoolExpr::OR:
+                y = zeros;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V x = slots[args[i] >> 1];
+                    y |= (args[i] & 1) ? ~x : x;
+                }
+                break;
+
+            case BoolExpr::AND:
+                y = ones;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V x = slots[args[i] >> 1];
+                    y &= (args[i] & 1) ? ~x : x;
+                }
+                break;
+
+            case BoolExpr::XOR:
+                y = zeros;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V x = slots[args[i] >> 1];
+                    y ^= (args[i] & 1) ? ~x : x;
+                }
+                break;
+
+            case BoolExpr::EQ: {
+                // All ones, or all zeros
+                V all = ones;
+                V any = zeros;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V x = slots[args[i] >> 1];
+                    x = (args[i] & 1) ? ~x : x;
+                    all &= x;
+                    any |= x;
+                }
+                y = all | ~any;
+                break;
+            }
+
+            case BoolExpr::IMPL: {
+                V p = slots[args[0] >> 1];
+                V q = slots[args[1] >> 1];
+                p = (args[0] & 1) ? ~p : p;
+                q = (args[1] & 1) ? ~q : q;
+                y = ~p | q;
+                break;
+            }
+
+            // IfThenElse
+            default: {
+                V s = slots[args[0] >> 1];
+                V d1 = slots[args[1] >> 1];
+                V d0 = slots[args[2] >> 1];
+                s = (args[0] & 1) ? ~s : s;
+                d1 = (args[1] & 1) ? ~d1 : d1;
+                d0 = (args[2] & 1) ? ~d0 : d0;
+                y = (s & d1) | (~s & d0);
+                break;
+            }
+        }
+
+        slots[instr.out] = instr.neg ? ~y : y;
+    }
+}
+
+
+// Two-rail version of _simulate.
+// Slot s holds its ones rail in slots[2s] and its zeros rail in slots[2s+1],
+// so operand code c has its ones rail in slots[c], and zeros in slots[c^1].
+// An empty value, with neither rail set, is illogical.
+template <typename V>
+static inline __attribute__((always_inline)) void
+_simulate3(Tape::Instr const * instrs, size_t n,
+           uint32_t const * operands, V * slots)
+{
+    V const zeros = V();
+    V const ones = ~zeros;
+
+    for (size_t j = 0; j < n; ++j) {
+        auto const & instr = instrs[j];
+        auto args = operands + instr.first;
+        V h, l;
+        V ill = zeros;
+
+        switch (instr.kind) {
+            case BoolExpr::OR:
+                h = zeros;
+                l = ones;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V xh = slots[args[i]];
+                    V xl = slots[args[i] ^ 1];
+                    h |= xh;
+                    l &= xl;
+                    ill |= ~(xh | xl);
+                }
+                break;
+
+            case BoolExpr::AND:
+                h = ones;
+                l = zeros;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V xh = slots[args[i]];
+                    V xl = slots[args[i] ^ 1];
+                    h &= xh;
+                    l |= xl;
+                    ill |= ~(xh | xl);
+                }
+                break;
+
+            case BoolExpr::XOR:
+                h = zeros;
+                l = ones;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V xh = slots[args[i]];
+                    V xl = slots[args[i] ^ 1];
+                    V y = (h & xl) | (l & xh);
+                    l = (h & xh) | (l & xl);
+                    h = y;
+                    ill |= ~(xh | xl);
+                }
+                break;
+
+            case BoolExpr::EQ: {
+                // Logical if any arg is, else one unless there's a 0 and a 1
+                V any0 = zeros;
+                V any1 = zeros;
+                V anyx = zeros;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    V xh = slots[args[i]];
+                    V xl = slots[args[i] ^ 1];
+                    any0 |= xl & ~xh;
+                    any1 |= xh & ~xl;
+                    anyx |= xh & xl;
+                    ill |= ~(xh | xl);
+                }
+                V both = any0 & any1;
+                h = anyx | ~both;
+                l = anyx | both;
+                break;
+            }
+
+            // ~p | q
+            case BoolExpr::IMPL: {
+                V ph = slots[args[0]];
+                V pl = slots[args[0] ^ 1];
+                V qh = slots[args[1]];
+                V ql = slots[args[1] ^ 1];
+                h = pl | qh;
+                l = ph & ql;
+                ill = ~(ph | pl) | ~(qh | ql);
+                break;
+            }
+
+            // IfThenElse
+            default: {
+                V sh = slots[args[0]];
+                V sl = slots[args[0] ^ 1];
+                V d1h = slots[args[1]];
+                V d1l = slots[args[1] ^ 1];
+                V d0h = slots[args[2]];
+                V d0l = slots[args[2] ^ 1];
+                h = (sh & d1h) | (sl & d0h);
+                l = (sh & d1l) | (sl & d0l);
+                ill = ~(sh | sl) | ~(d1h | d1l) | ~(d0h | d0l);
+                break;
+            }
+        }
+
+        // Illogical takes precedence
+        slots[2 * instr.out + instr.neg] = h & ~ill;
+        slots[2 * instr.out + !instr.neg] = l & ~ill;
+    }
+}
+
+
+using simulate_t = void (*)(Tape::Instr const *, size_t,
+                            uint32_t const *, uint64_t *);
+
+
+static void
+_simulate64(Tape::Instr const * instrs, size_t n,
+            uint32_t const * operands, uint64_t * slots)
+{
+    _simulate<uint64_t>(instrs, n, operands, slots);
+}
+
+
+static void
+_simulate3_64(Tape::Instr const * instrs, size_t n,
+              uint32_t const * operands, uint64_t * slots)
+{
+    _simulate3<uint64_t>(instrs, n, operands, slots);
+}
+
+
+#ifdef BX_SIMD
+__attribute__((target("avx2"))) static void
+_simulate256(Tape::Instr const * instrs, size_t n,
+             uint32_t const * operands, uint64_t * slots)
+{
+    _simulate<u64x4_t>(instrs, n, operands,
+                       reinterpret_cast<u64x4_t *>(slots));
+}
+
+
+__attribute__((target("avx512f"))) static void
+_simulate512(Tape::Instr const * instrs, size_t n,
+             uint32_t const * operands, uint64_t * slots)
+{
+    _simulate<u64x8_t>(instrs, n, operands,
+                       reinterpret_cast<u64x8_t *>(slots));
+}
+
+
+__attribute__((target("avx2"))) static void
+_simulate3_256(Tape::Instr const * instrs, size_t n,
+               uint32_t const * operands, uint64_t * slots)
+{
+    _simulate3<u64x4_t>(instrs, n, operands,
+                        reinterpret_cast<u64x4_t *>(slots));
+}
+
+
+__attribute__((target("avx512f"))) static void
+_simulate3_512(Tape::Instr const * instrs, size_t n,
+               uint32_t const * operands, uint64_t * slots)
+{
+    _simulate3<u64x8_t>(instrs, n, operands,
+                        reinterpret_cast<u64x8_t *>(slots));
+}
+#endif
+
+
+// Return size words of buf, aligned for the widest kernel
+static uint64_t *
+_aligned(vector<uint64_t> & buf, size_t size)
+{
+    buf.resize(size + 8);
+    auto offset = reinterpret_cast<uintptr_t>(buf.data()) % 64;
+    return buf.data() + (offset ? (64 - offset) / 8 : 0);
+}
+
+
+// Pick the widest supported pass that is no wider than width,
+// and return its kernel.
+static simulate_t
+_kernel(size_t & width, simulate_t k64, simulate_t k256, simulate_t k512)
+{
+    if (width == 0) {
+        width = 512;
+    }
+#ifdef BX_SIMD
+    if (width >= 512 && __builtin_cpu_supports("avx512f")) {
+        width = 512;
+        return k512;
+    }
+    if (width >= 256 && __builtin_cpu_supports("avx2")) {
+        width = 256;
+        return k256;
+    }
+#endif
+    width = 64;
+    return k64;
+}
+
+
+vector<vector<uint64_t>>
+Tape::simulate(vector<vector<uint64_t>> const & words, size_t width) const
+{
+    assert(words.size() == inputs.size());
+
+    size_t n = inputs.empty() ? 1 : words[0].size();
+    for (auto const & xs : words) {
+        assert(xs.size() == n);
+    }
+
+#ifdef BX_SIMD
+    auto kernel = _kernel(width, _simulate64, _simulate256, _simulate512);
+#else
+    auto kernel = _kernel(width, _simulate64, nullptr, nullptr);
+#endif
+
+    // Words per slot in one pass
+    size_t m = width / 64;
+
+    vector<uint64_t> buf;
+    auto slots = _aligned(buf, init.size() * m);
+    for (size_t i = 0; i < init.size(); ++i) {
+        if (init[i] == BoolExpr::ONE) {
+            std::fill_n(slots + i * m, m, ~uint64_t(0));
+        }
+    }
+
+    vector<vector<uint64_t>> ys(outputs.size(), vector<uint64_t>(n));
+
+    for (size_t base = 0; base < n; base += m) {
+        size_t k = std::min(m, n - base);
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto first = words[i].begin() + base;
+            std::copy(first, first + k, slots + i * m);
+        }
+
+        kernel(instrs.data(), instrs.size(), operands.data(), slots);
+
+        for (size_t j = 0; j < outputs.size(); ++j) {
+            auto code = outputs[j];
+            auto mask = (code & 1) ? ~uint64_t(0) : uint64_t(0);
+            auto first = slots + (code >> 1) * m;
+            for (size_t w = 0; w < k; ++w) {
+                ys[j][base + w] = first[w] ^ mask;
+            }
+        }
+    }
+
+    return ys;
+}
+
+
+std::pair<vector<vector<uint64_t>>, vector<vector<uint64_t>>>
+Tape::simulate_ternary(vector<vector<uint64_t>> const & ones,
+                       vector<vector<uint64_t>> const & zeros,
+                       size_t width) const
+{
+    assert(ones.size() == inputs.size());
+    assert(zeros.size() == inputs.size());
+
+    size_t n = inputs.empty() ? 1 : ones[0].size();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        assert(ones[i].size() == n);
+        assert(zeros[i].size() == n);
+    }
+
+#ifdef BX_SIMD
+    auto kernel = _kernel(width, _simulate3_64, _simulate3_256,
+                          _simulate3_512);
+#else
+    auto kernel = _kernel(width, _simulate3_64, nullptr, nullptr);
+#endif
+
+    // Words per rail in one pass
+    size_t m = width / 64;
+
+    vector<uint64_t> buf;
+    auto slots = _aligned(buf, 2 * init.size() * m);
+    for (size_t i = 0; i < init.size(); ++i) {
+        // Zero, one, and logical; illogical is empty
+        auto v = init[i];
+        auto h = (v == BoolExpr::ONE || v == BoolExpr::LOG);
+        auto l = (v == BoolExpr::ZERO || v == BoolExpr::LOG);
+        std::fill_n(slots + 2 * i * m, m, h ? ~uint64_t(0) : 0);
+        std::fill_n(slots + (2 * i + 1) * m, m, l ? ~uint64_t(0) : 0);
+    }
+
+    vector<vector<uint64_t>> hs(outputs.size(), vector<uint64_t>(n));
+    vector<vector<uint64_t>> ls(outputs.size(), vector<uint64_t>(n));
+
+    for (size_t base = 0; base < n; base += m) {
+        size_t k = std::min(m, n - base);
+
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto first = ones[i].begin() + base;
+            std::copy(first, first + k, slots + 2 * i * m);
+            first = zeros[i].begin() + base;
+            std::copy(first, first + k, slots + (2 * i + 1) * m);
+        }
+
+        kernel(instrs.data(), instrs.size(), operands.data(), slots);
+
+        for (size_t j = 0; j < outputs.size(); ++j) {
+            auto code = outputs[j];
+            std::copy_n(slots + code * m, k, hs[j].begin() + base);
+            std::copy_n(slots + (code ^ 1) * m, k,
+                        ls[j].begin() + base);
+        }
+    }
+
+    return {hs, ls};
+}
+
+
+}  // namespace boolexpr
@@ -0,0 +1,300 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "boolexpr/boolexpr.h"
+#include "eval.h"
+#include "unique.h"
+
+
+using std::unordered_map;
+using std::vector;
+
+
+namespace boolexpr {
+
+
+Tape::Tape(bx_t const & bx)
+{
+    compile({bx});
+}
+
+
+Tape::Tape(Array const & array)
+{
+    compile(vector<bx_t>(array.begin(), array.end()));
+}
+
+
+void
+Tape::compile(vector<bx_t> const & roots)
+{
+    // Inputs go first, sorted by id
+    vector<Variable const *> vars;
+    for (bx_t const & root : roots) {
+        auto const & xs = root->support_vars();
+        vars.insert(vars.end(), xs.cbegin(), xs.cend());
+    }
+    std::sort(vars.begin(), vars.end(), VarLess());
+    vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+
+    unordered_map<Variable const *, uint32_t> var2slot;
+    for (auto x : vars) {
+        var2slot.insert({x, inputs.size()});
+        inputs.push_back(var_t(x));
+        init.push_back(BoolExpr::LOG);
+    }
+
+    // dfs_iter visits the nodes under each root once, in post-order.
+    // Nodes shared with an earlier root already have a code.
+    unordered_map<BoolExpr const *, uint32_t> codes;
+    for (bx_t const & root : roots) {
+        for (auto it = dfs_iter(root); it != dfs_iter(); ++it) {
+            auto bx = (*it).get();
+            if (codes.find(bx) != codes.end()) {
+                continue;
+            }
+
+            uint32_t code;
+
+            if (IS_VAR(bx)) {
+                code = var2slot[static_cast<Variable const *>(bx)] << 1;
+            }
+            else if (IS_COMP(bx)) {
+                auto x = abs(lit_t(static_cast<Literal const *>(bx)));
+                code = (var2slot[static_cast<Variable const *>(x.get())] << 1)
+                       | 1;
+            }
+            else if (IS_CONST(bx)) {
+                code = init.size() << 1;
+                init.push_back(bx->kind);
+            }
+            else {
+                auto op = static_cast<Operator const *>(bx);
+                code = init.size() << 1;
+                init.push_back(BoolExpr::LOG);
+
+                Instr instr;
+                instr.kind = static_cast<BoolExpr::Kind>(op->kind | 1);
+                instr.neg = !(op->kind & 1);
+                instr.first = operands.size();
+                instr.n = op->args.size();
+                instr.out = code >> 1;
+                instrs.push_back(instr);
+
+                for (bx_t const & arg : op->args) {
+                    operands.push_back(codes[arg.get()]);
+                }
+            }
+
+            codes.insert({bx, code});
+        }
+    }
+
+    for (bx_t const & root : roots) {
+        outputs.push_back(codes[root.get()]);
+    }
+}
+
+
+std::vector<var_t> const &
+Tape::get_inputs() const
+{
+    return inputs;
+}
+
+
+size_t
+Tape::num_instrs() const
+{
+    return instrs.size();
+}
+
+
+size_t
+Tape::num_outputs() const
+{
+    return outputs.size();
+}
+
+
+// Each instruction follows the rules of simplify,
+// with illogical, then the dominator, then logical taking precedence.
+void
+Tape::run(vector<value_t> & slots) const
+{
+    auto get = [&slots] (uint32_t code) {
+        auto v = slots[code >> 1];
+        return (code & 1) ? value_not(v) : v;
+    };
+
+    for (auto const & instr : instrs) {
+        auto args = operands.data() + instr.first;
+        uint32_t mask = 0;
+        value_t v;
+
+        switch (instr.kind) {
+            case BoolExpr::OR:
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    mask |= 1u << get(args[i]);
+                }
+                v = (mask & (1u << BoolExpr::ILL)) ? BoolExpr::ILL
+                  : (mask & (1u << BoolExpr::ONE)) ? BoolExpr::ONE
+                  : (mask & (1u << BoolExpr::LOG)) ? BoolExpr::LOG
+                  : BoolExpr::ZERO;
+                break;
+
+            case BoolExpr::AND:
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    mask |= 1u << get(args[i]);
+                }
+                v = (mask & (1u << BoolExpr::ILL)) ? BoolExpr::ILL
+                  : (mask & (1u << BoolExpr::ZERO)) ? BoolExpr::ZERO
+                  : (mask & (1u << BoolExpr::LOG)) ? BoolExpr::LOG
+                  : BoolExpr::ONE;
+                break;
+
+            case BoolExpr::XOR: {
+                uint32_t parity = 0;
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    auto x = get(args[i]);
+                    mask |= 1u << x;
+                    parity ^= x & 1;
+                }
+                v = (mask & (1u << BoolExpr::ILL)) ? BoolExpr::ILL
+                  : (mask & (1u << BoolExpr::LOG)) ? BoolExpr::LOG
+                  : static_cast<value_t>(parity);
+                break;
+            }
+
+            case BoolExpr::EQ:
+                for (uint32_t i = 0; i < instr.n; ++i) {
+                    mask |= 1u << get(args[i]);
+                }
+                v = (mask & (1u << BoolExpr::ILL)) ? BoolExpr::ILL
+                  : (mask & (1u << BoolExpr::LOG)) ? BoolExpr::LOG
+                  : ((mask & 3) == 3) ? BoolExpr::ZERO
+                  : BoolExpr::ONE;
+                break;
+
+            case BoolExpr::IMPL: {
+                auto p = get(args[0]);
+                auto q = get(args[1]);
+                if (p == BoolExpr::ILL || q == BoolExpr::ILL) {
+                    v = BoolExpr::ILL;
+                }
+                else if (p == BoolExpr::ZERO || q == BoolExpr::ONE) {
+                    v = BoolExpr::ONE;
+                }
+                else if (p == BoolExpr::ONE) {
+                    v = q;
+                }
+                else if (q == BoolExpr::ZERO) {
+                    v = value_not(p);
+                }
+                else {
+                    v = BoolExpr::LOG;
+                }
+                break;
+            }
+
+            // IfThenElse
+            default: {
+                auto s = get(args[0]);
+                auto d1 = get(args[1]);
+                auto d0 = get(args[2]);
+                if (s == BoolExpr::ILL || d1 == BoolExpr::ILL
+                        || d0 == BoolExpr::ILL) {
+                    v = BoolExpr::ILL;
+                }
+                else if (s == BoolExpr::ONE) {
+                    v = d1;
+                }
+                else if (s == BoolExpr::ZERO) {
+                    v = d0;
+                }
+                else {
+                    // X ? d1 : d1 <=> d1
+                    v = (d1 == d0 && d1 >> 2 == 0) ? d1 : BoolExpr::LOG;
+                }
+                break;
+            }
+        }
+
+        slots[instr.out] = instr.neg ? value_not(v) : v;
+    }
+}
+
+
+// Load one point into the input slots.
+// Inputs past the end of bits are logical (X), and extra bits are ignored.
+static void
+_load(vector<value_t> & slots, size_t n, vector<bool> const & bits)
+{
+    for (size_t i = 0; i < n; ++i) {
+        slots[i] = i < bits.size() ? static_cast<value_t>(bits[i])
+                                   : BoolExpr::LOG;
+    }
+}
+
+
+vector<const_t>
+Tape::eval(vector<bool> const & bits) const
+{
+    auto slots = init;
+    _load(slots, inputs.size(), bits);
+
+    run(slots);
+
+    vector<const_t> ys;
+    for (auto code : outputs) {
+        auto v = slots[code >> 1];
+        ys.push_back(value_const((code & 1) ? value_not(v) : v));
+    }
+    return ys;
+}
+
+
+vector<vector<const_t>>
+Tape::eval_batch(vector<vector<bool>> const & points) const
+{
+    vector<vector<const_t>> yss;
+    yss.reserve(points.size());
+
+    // Constants never change, so only reset the inputs between points
+    auto slots = init;
+
+    for (auto const & bits : points) {
+        _load(slots, inputs.size(), bits);
+
+        run(slots);
+
+        vector<const_t> ys;
+        ys.reserve(outputs.size());
+        for (auto code : outputs) {
+            auto v = slots[code >> 1];
+            ys.push_back(value_const((code & 1) ? value_not(v) : v));
+        }
+        yss.push_back(std::move(ys));
+    }
+
+    return yss;
+}
+
+
+}  // namespace boolexpr
@@ -18,7 +18,7 @@
 #include "boolexpr/boolexpr.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::string;
 
 
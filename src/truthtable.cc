@@ -0,0 +1,425 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "boolexpr/boolexpr.h"
+#include "unique.h"
+
+
+using std::vector;
+
+
+namespace boolexpr {
+
+
+// Variable i of a one-word table, for i < 6
+static uint64_t const _masks[6] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL,
+};
+
+
+static size_t const _max_vars = 16;
+
+
+static size_t
+_num_words(size_t n)
+{
+    return n > 6 ? size_t(1) << (n - 6) : 1;
+}
+
+
+// Cofactors of one word, for variable i < 6
+static uint64_t
+_cofactor0(uint64_t w, size_t i)
+{
+    w &= ~_masks[i];
+    return w | (w << (1u << i));
+}
+
+
+static uint64_t
+_cofactor1(uint64_t w, size_t i)
+{
+    w &= _masks[i];
+    return w | (w >> (1u << i));
+}
+
+
+static uint64_t
+_apply(BoolExpr::Kind kind, uint64_t x, uint64_t y)
+{
+    switch (kind) {
+        case BoolExpr::OR:
+            return x | y;
+        case BoolExpr::AND:
+            return x & y;
+        default:
+            return x ^ y;
+    }
+}
+
+
+TruthTable::TruthTable(vector<var_t> const & vars,
+                       vector<uint64_t> const & words)
+    : vars {vars}
+    , words {words}
+{
+    assert(vars.size() <= _max_vars);
+    assert(std::is_sorted(vars.cbegin(), vars.cend(), VarLess()));
+    assert(words.size() == _num_words(vars.size()));
+}
+
+
+vector<var_t> const &
+TruthTable::get_vars() const
+{
+    return vars;
+}
+
+
+vector<uint64_t> const &
+TruthTable::get_words() const
+{
+    return words;
+}
+
+
+size_t
+TruthTable::index(var_t const & x) const
+{
+    auto it = std::lower_bound(vars.cbegin(), vars.cend(), x, VarLess());
+    return it - vars.cbegin();
+}
+
+
+bool
+TruthTable::is_zero() const
+{
+    for (auto w : words) {
+        if (w != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool
+TruthTable::is_one() const
+{
+    for (auto w : words) {
+        if (w != ~uint64_t(0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+uint64_t
+TruthTable::count() const
+{
+    uint64_t n = 0;
+    for (auto w : words) {
+        n += __builtin_popcountll(w);
+    }
+    // Drop the repeats
+    if (vars.size() < 6) {
+        n >>= 6 - vars.size();
+    }
+    return n;
+}
+
+
+bool
+TruthTable::equiv(TruthTable const & other) const
+{
+    assert(vars == other.vars);
+    return words == other.words;
+}
+
+
+TruthTable
+TruthTable::operator~() const
+{
+    auto ws = words;
+    for (auto & w : ws) {
+        w = ~w;
+    }
+    return TruthTable(vars, ws);
+}
+
+
+TruthTable
+TruthTable::operator|(TruthTable const & other) const
+{
+    assert(vars == other.vars);
+    auto ws = words;
+    for (size_t i = 0; i < ws.size(); ++i) {
+        ws[i] |= other.words[i];
+    }
+    return TruthTable(vars, ws);
+}
+
+
+TruthTable
+TruthTable::operator&(TruthTable const & other) const
+{
+    assert(vars == other.vars);
+    auto ws = words;
+    for (size_t i = 0; i < ws.size(); ++i) {
+        ws[i] &= other.words[i];
+    }
+    return TruthTable(vars, ws);
+}
+
+
+TruthTable
+TruthTable::operator^(TruthTable const & other) const
+{
+    assert(vars == other.vars);
+    auto ws = words;
+    for (size_t i = 0; i < ws.size(); ++i) {
+        ws[i] ^= other.words[i];
+    }
+    return TruthTable(vars, ws);
+}
+
+
+TruthTable
+TruthTable::cofactor(var_t const & x, bool value) const
+{
+    auto i = index(x);
+    assert(i < vars.size() && vars[i] == x);
+
+    auto ws = words;
+    if (i < 6) {
+        for (auto & w : ws) {
+            w = value ? _cofactor1(w, i) : _cofactor0(w, i);
+        }
+    }
+    else {
+        // Words w and w+d differ only in x
+        size_t d = size_t(1) << (i - 6);
+        for (size_t w = 0; w < ws.size(); ++w) {
+            if (!(w & d)) {
+                ws[w] = ws[w + d] = value ? words[w + d] : words[w];
+            }
+        }
+    }
+    return TruthTable(vars, ws);
+}
+
+
+// Reduce the two cofactors of each variable in xs with Or, And, or Xor
+TruthTable
+TruthTable::cofactors(vector<var_t> const & xs, BoolExpr::Kind kind) const
+{
+    auto ws = words;
+
+    for (auto const & x : xs) {
+        auto i = index(x);
+        if (i == vars.size() || vars[i] != x) {
+            // f does not depend on x, and f ^ f = 0
+            if (kind == BoolExpr::XOR) {
+                std::fill(ws.begin(), ws.end(), 0);
+            }
+            continue;
+        }
+
+        if (i < 6) {
+            for (auto & w : ws) {
+                w = _apply(kind, _cofactor0(w, i), _cofactor1(w, i));
+            }
+        }
+        else {
+            size_t d = size_t(1) << (i - 6);
+            for (size_t w = 0; w < ws.size(); ++w) {
+                if (!(w & d)) {
+                    ws[w] = ws[w + d] = _apply(kind, ws[w], ws[w + d]);
+                }
+            }
+        }
+    }
+
+    return TruthTable(vars, ws);
+}
+
+
+TruthTable
+TruthTable::smoothing(vector<var_t> const & xs) const
+{
+    return cofactors(xs, BoolExpr::OR);
+}
+
+
+TruthTable
+TruthTable::consensus(vector<var_t> const & xs) const
+{
+    return cofactors(xs, BoolExpr::AND);
+}
+
+
+TruthTable
+TruthTable::derivative(vector<var_t> const & xs) const
+{
+    return cofactors(xs, BoolExpr::XOR);
+}
+
+
+soln_t
+TruthTable::sat() const
+{
+    for (size_t w = 0; w < words.size(); ++w) {
+        if (words[w] != 0) {
+            auto k = (w << 6) | __builtin_ctzll(words[w]);
+            point_t point;
+            for (size_t i = 0; i < vars.size(); ++i) {
+                if ((k >> i) & 1) {
+                    point.insert({vars[i], one()});
+                }
+                else {
+                    point.insert({vars[i], zero()});
+                }
+            }
+            return std::make_pair(true, std::move(point));
+        }
+    }
+    return std::make_pair(false, boost::none);
+}
+
+
+// A one-word table of vars[0] ... vars[n-1]
+static bx_t
+_word_to_bx(vector<var_t> const & vars, uint64_t w, size_t n)
+{
+    if (w == 0) {
+        return zero();
+    }
+    if (w == ~uint64_t(0)) {
+        return one();
+    }
+
+    auto f0 = _cofactor0(w, n - 1);
+    auto f1 = _cofactor1(w, n - 1);
+    if (f0 == f1) {
+        return _word_to_bx(vars, f0, n - 1);
+    }
+    return ite_s(vars[n - 1], _word_to_bx(vars, f1, n - 1),
+                 _word_to_bx(vars, f0, n - 1));
+}
+
+
+// A table of vars[0] ... vars[n-1] that starts at words
+static bx_t
+_to_bx(vector<var_t> const & vars, uint64_t const * words, size_t n)
+{
+    if (n <= 6) {
+        return _word_to_bx(vars, words[0], n);
+    }
+
+    // The upper half has vars[n-1] = 1
+    auto half = _num_words(n - 1);
+    auto f0 = words;
+    auto f1 = words + half;
+    if (std::equal(f0, f0 + half, f1)) {
+        return _to_bx(vars, f0, n - 1);
+    }
+    return ite_s(vars[n - 1], _to_bx(vars, f1, n - 1),
+                 _to_bx(vars, f0, n - 1));
+}
+
+
+bx_t
+TruthTable::to_bx() const
+{
+    return _to_bx(vars, words.data(), vars.size());
+}
+
+
+boost::optional<TruthTable>
+truth_table(bx_t const & f)
+{
+    auto const & xs = f->support_vars();
+    if (xs.size() > _max_vars) {
+        return boost::none;
+    }
+    return truth_table(f, vector<var_t>(xs.cbegin(), xs.cend()));
+}
+
+
+// Simulate f on every point at once.
+// Two rails catch any point where f is logical or illogical.
+boost::optional<TruthTable>
+truth_table(bx_t const & f, vector<var_t> const & xs)
+{
+    auto vars = xs;
+    std::sort(vars.begin(), vars.end(), VarLess());
+    vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+    if (vars.size() > _max_vars) {
+        return boost::none;
+    }
+
+    auto n = _num_words(vars.size());
+
+    Tape tape(f);
+    vector<vector<uint64_t>> ones;
+    vector<vector<uint64_t>> zeros;
+    for (auto const & x : tape.get_inputs()) {
+        auto it = std::lower_bound(vars.cbegin(), vars.cend(), x, VarLess());
+        if (it == vars.cend() || *it != x) {
+            return boost::none;
+        }
+        size_t i = it - vars.cbegin();
+
+        vector<uint64_t> ws(n);
+        for (size_t w = 0; w < n; ++w) {
+            if (i < 6) {
+                ws[w] = _masks[i];
+            }
+            else {
+                ws[w] = ((w >> (i - 6)) & 1) ? ~uint64_t(0) : 0;
+            }
+        }
+        ones.push_back(ws);
+        for (auto & w : ws) {
+            w = ~w;
+        }
+        zeros.push_back(ws);
+    }
+
+    auto ys = tape.simulate_ternary(ones, zeros);
+    auto const & hs = ys.first[0];
+    auto const & ls = ys.second[0];
+    for (size_t w = 0; w < n; ++w) {
+        if ((hs[w] ^ ls[w]) != ~uint64_t(0)) {
+            return boost::none;
+        }
+    }
+
+    return TruthTable(vars, hs);
+}
+
+
+}  // namespace boolexpr
@@ -16,7 +16,7 @@
 #include "boolexpr/boolexpr.h"
 
 
-using std::static_pointer_cast;
+using boost::static_pointer_cast;
 using std::string;
 using std::vector;
 
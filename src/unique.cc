@@ -0,0 +1,289 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+#include <new>
+
+#include "boolexpr/boolexpr.h"
+#include "pool.h"
+#include "unique.h"
+
+
+using boost::static_pointer_cast;
+using std::vector;
+
+
+namespace boolexpr {
+
+
+UniqueTable::UniqueTable()
+    : enabled {false}
+    , count {0}
+{}
+
+
+size_t
+UniqueTable::hash(BoolExpr::Kind kind, bool simple,
+                  bx_t const * args, size_t n)
+{
+    size_t h = (static_cast<size_t>(kind) << 1) | static_cast<size_t>(simple);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= std::hash<BoolExpr const *>()(args[i].get())
+             + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+
+bool
+UniqueTable::get_enabled() const
+{
+    return enabled;
+}
+
+
+void
+UniqueTable::set_enabled(bool enable)
+{
+    enabled = enable;
+}
+
+
+size_t
+UniqueTable::size() const
+{
+    return count;
+}
+
+
+op_t
+UniqueTable::lookup(BoolExpr::Kind kind, bool simple,
+                    vector<bx_t> const & args) const
+{
+    auto h = hash(kind, simple, args.data(), args.size());
+    auto range = table.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        auto op = it->second;
+        if (op->kind == kind && op->simple == simple
+                && op->args.size() == args.size()
+                && std::equal(args.cbegin(), args.cend(), op->args.cbegin())) {
+            // Skip a node that another thread is destroying
+            if (op->try_add_ref()) {
+                return op_t(op, false);
+            }
+        }
+    }
+    return nullptr;
+}
+
+
+void
+UniqueTable::erase(Operator const * op)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto h = hash(op->kind, op->simple, op->args.data(), op->args.size());
+    auto range = table.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == op) {
+            table.erase(it);
+            --count;
+            return;
+        }
+    }
+}
+
+
+template <typename T, typename... Args>
+static op_t
+_alloc(Args const &... args)
+{
+    auto arena = current_arena();
+    if (arena == nullptr) {
+        return op_t(new T(args...));
+    }
+    return op_t(arena->create<T>(args...));
+}
+
+
+static op_t
+_new_op(BoolExpr::Kind kind, bool simple, vector<bx_t> const & args)
+{
+    switch (kind) {
+        case BoolExpr::NOR:
+            return _alloc<Nor>(simple, args);
+        case BoolExpr::OR:
+            return _alloc<Or>(simple, args);
+        case BoolExpr::NAND:
+            return _alloc<Nand>(simple, args);
+        case BoolExpr::AND:
+            return _alloc<And>(simple, args);
+        case BoolExpr::XNOR:
+            return _alloc<Xnor>(simple, args);
+        case BoolExpr::XOR:
+            return _alloc<Xor>(simple, args);
+        case BoolExpr::NEQ:
+            return _alloc<Unequal>(simple, args);
+        case BoolExpr::EQ:
+            return _alloc<Equal>(simple, args);
+        case BoolExpr::NIMPL:
+            return _alloc<NotImplies>(simple, args[0], args[1]);
+        case BoolExpr::IMPL:
+            return _alloc<Implies>(simple, args[0], args[1]);
+        case BoolExpr::NITE:
+            return _alloc<NotIfThenElse>(simple, args[0], args[1], args[2]);
+        case BoolExpr::ITE:
+            return _alloc<IfThenElse>(simple, args[0], args[1], args[2]);
+        default:
+            return nullptr;  // LCOV_EXCL_LINE
+    }
+}
+
+
+op_t
+UniqueTable::get(BoolExpr::Kind kind, bool simple, vector<bx_t> const & args)
+{
+    // Hold the lock while creating the node,
+    // so two threads can't insert equal nodes.
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto op = lookup(kind, simple, args);
+    if (op == nullptr) {
+        op = _new_op(kind, simple, args);
+        auto h = hash(kind, simple, op->args.data(), op->args.size());
+        table.insert({h, op.get()});
+        ++count;
+    }
+
+    return op;
+}
+
+
+// The splitmix64 finalizer
+uint64_t
+hash_mix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+
+// NOTE: Never destroyed, b/c nodes may outlive static destruction.
+UniqueTable &
+unique_table()
+{
+    static auto _table = new UniqueTable();
+    return *_table;
+}
+
+
+static std::atomic<bool> _canonical {false};
+
+
+// Nor, Or, Nand, And, Xnor, Xor, Unequal, Equal
+static bool
+_is_commutative(BoolExpr::Kind kind)
+{
+    // IS_NARY only reads the kind, so test a stand-in for the new node
+    struct { BoolExpr::Kind kind; } const op {kind};
+    return IS_NARY(&op);
+}
+
+
+// Order by structural hash, so the order depends on what the arguments are,
+// not when they were made.
+// Serial numbers only break ties.
+static bool
+_canonical_lt(bx_t const & x, bx_t const & y)
+{
+    auto hx = x->structural_hash();
+    auto hy = y->structural_hash();
+    if (hx != hy) {
+        return hx < hy;
+    }
+    return x->serial < y->serial;
+}
+
+
+op_t
+make_op(BoolExpr::Kind kind, bool simple, vector<bx_t> const & args)
+{
+    if (_canonical && _is_commutative(kind)
+            && !std::is_sorted(args.cbegin(), args.cend(), _canonical_lt)) {
+        auto sorted = args;
+        std::sort(sorted.begin(), sorted.end(), _canonical_lt);
+        return make_op(kind, simple, sorted);
+    }
+
+    auto & table = unique_table();
+
+    if (!table.get_enabled()) {
+        return _new_op(kind, simple, args);
+    }
+
+    return table.get(kind, simple, args);
+}
+
+
+op_t
+make_op(BoolExpr::Kind kind, bool simple, ArgVec const & args)
+{
+    return make_op(kind, simple, vector<bx_t>(args.cbegin(), args.cend()));
+}
+
+
+bool
+unique_table_enabled()
+{
+    return unique_table().get_enabled();
+}
+
+
+bool
+enable_unique_table(bool enable)
+{
+    auto & table = unique_table();
+    auto prev = table.get_enabled();
+    table.set_enabled(enable);
+    return prev;
+}
+
+
+size_t
+unique_table_size()
+{
+    return unique_table().size();
+}
+
+
+bool
+canonical_order_enabled()
+{
+    return _canonical;
+}
+
+
+bool
+enable_canonical_order(bool enable)
+{
+    return _canonical.exchange(enable);
+}
+
+
+}  // namespace boolexpr
@@ -0,0 +1,93 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// WARNING:
+//     The contents of this file are implementation details.
+//     Do not use these declarations for anything,
+//     because they may change without notice.
+
+
+namespace boolexpr {
+
+
+// Maps (kind, simple, arg pointers) to a live operator node.
+// Entries hold raw pointers; nodes remove themselves on destruction.
+// All methods are safe to call from multiple threads.
+class UniqueTable
+{
+    std::atomic<bool> enabled;
+    std::atomic<size_t> count;
+
+    std::mutex mutex;
+    std::unordered_multimap<size_t, Operator const *> table;
+
+    static size_t hash(BoolExpr::Kind kind, bool simple,
+                       bx_t const * args, size_t n);
+
+    op_t lookup(BoolExpr::Kind kind, bool simple,
+                std::vector<bx_t> const & args) const;
+
+public:
+    UniqueTable();
+
+    bool get_enabled() const;
+    void set_enabled(bool enable);
+    size_t size() const;
+
+    // Return the live node with these fields, or create and insert one
+    op_t get(BoolExpr::Kind kind, bool simple, std::vector<bx_t> const & args);
+    void erase(Operator const * op);
+};
+
+
+UniqueTable & unique_table();
+
+
+// Scramble the bits of a 64-bit hash
+uint64_t hash_mix(uint64_t h);
+
+
+// Order nodes by serial number, which is their order of creation
+inline bool
+serial_lt(bx_t const & x, bx_t const & y)
+{
+    return x->serial < y->serial;
+}
+
+
+// Order variables by id, then by context
+struct VarLess
+{
+    bool operator()(Variable const * x, Variable const * y) const
+    {
+        if (x->id != y->id) {
+            return x->id < y->id;
+        }
+        return std::less<Context const *>()(x->ctx, y->ctx);
+    }
+
+    bool operator()(var_t const & x, var_t const & y) const
+    {
+        return (*this)(x.get(), y.get());
+    }
+};
+
+
+// Every operator node is created through this factory.
+op_t make_op(BoolExpr::Kind kind, bool simple, std::vector<bx_t> const & args);
+op_t make_op(BoolExpr::Kind kind, bool simple, ArgVec const & args);
+
+
+} // namespace boolexpr
@@ -0,0 +1,82 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+using boost::static_pointer_cast;
+using std::vector;
+
+
+class ArgVecTest : public BoolExprTest {};
+
+
+TEST_F(ArgVecTest, Inline)
+{
+    auto y0 = static_pointer_cast<Operator const>(ite(xs[0], xs[1], xs[2]));
+    EXPECT_TRUE(y0->args.is_inline());
+    EXPECT_EQ(y0->args.size(), 3);
+    EXPECT_EQ(y0->args[0], xs[0]);
+    EXPECT_EQ(y0->args[1], xs[1]);
+    EXPECT_EQ(y0->args[2], xs[2]);
+
+    auto y1 = static_pointer_cast<Operator const>(xs[0] | xs[1]);
+    EXPECT_TRUE(y1->args.is_inline());
+    EXPECT_EQ(y1->args.size(), 2);
+}
+
+
+TEST_F(ArgVecTest, Heap)
+{
+    vector<bx_t> args;
+    for (int i = 0; i < 8; ++i) {
+        args.push_back(xs[i]);
+    }
+
+    auto y0 = static_pointer_cast<Operator const>(xor_(args));
+    EXPECT_FALSE(y0->args.is_inline());
+    EXPECT_EQ(y0->args.size(), 8);
+
+    auto it = y0->args.cbegin();
+    for (int i = 0; i < 8; ++i, ++it) {
+        EXPECT_EQ(*it, xs[i]);
+    }
+    EXPECT_EQ(it, y0->args.cend());
+
+    auto rit = y0->args.crbegin();
+    for (int i = 7; i >= 0; --i, ++rit) {
+        EXPECT_EQ(*rit, xs[i]);
+    }
+    EXPECT_EQ(rit, y0->args.crend());
+}
+
+
+TEST_F(ArgVecTest, Transform)
+{
+    auto y0 = (xs[0] | xs[1]) & xor_s({xs[2], xs[3]});
+    auto y1 = y0->restrict_({{xs[0], _zero}});
+    auto op1 = static_pointer_cast<Operator const>(y1);
+    EXPECT_EQ(op1->args.size(), 2);
+
+    // Unmodified subexpressions are shared, not copied
+    auto xor_arg = static_pointer_cast<Operator const>(y0)->args[1];
+    auto it = std::find(op1->args.cbegin(), op1->args.cend(), xor_arg);
+    EXPECT_NE(it, op1->args.cend());
+}
@@ -26,21 +26,21 @@ TEST_F(BoolExprTest, Basic)
     EXPECT_EQ(~_log, _log);
     EXPECT_EQ(~_ill, _ill);
 
-    auto x = std::static_pointer_cast<const Literal>(xs[0]);
-    auto xn = std::static_pointer_cast<const Literal>(~xs[0]);
-    auto y = std::static_pointer_cast<const Literal>(xs[1]);
+    auto x = boost::static_pointer_cast<const Literal>(xs[0]);
+    auto xn = boost::static_pointer_cast<const Literal>(~xs[0]);
+    auto y = boost::static_pointer_cast<const Literal>(xs[1]);
 
     EXPECT_LT(x, y);
     EXPECT_LT(xn, x);
 
     vector<lit_t> lits;
-    lits.push_back(std::static_pointer_cast<const Literal>(xs[7]));
-    lits.push_back(std::static_pointer_cast<const Literal>(xs[13]));
-    lits.push_back(std::static_pointer_cast<const Literal>(~xs[3]));
-    lits.push_back(std::static_pointer_cast<const Literal>(xs[5]));
-    lits.push_back(std::static_pointer_cast<const Literal>(~xs[13]));
-    lits.push_back(std::static_pointer_cast<const Literal>(xs[3]));
-    lits.push_back(std::static_pointer_cast<const Literal>(~xs[5]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(xs[7]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(xs[13]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(~xs[3]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(xs[5]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(~xs[13]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(xs[3]));
+    lits.push_back(boost::static_pointer_cast<const Literal>(~xs[5]));
     std::sort(lits.begin(), lits.end());
     EXPECT_EQ(lits[0]->id, 8<<1);      // ~xs[3]
     EXPECT_EQ(lits[1]->id, 8<<1 | 1);  //  xs[3]
@@ -297,3 +297,68 @@ TEST_F(BoolExprTest, Support)
 
     EXPECT_EQ(y->support(), s);
 }
+
+
+TEST_F(BoolExprTest, SupportVars)
+{
+    auto y0 = ~xs[3] & xs[1];
+    auto y1 = y0 | (~xs[2] & xs[1]) | y0;
+
+    std::vector<Variable const *> s = {xs[1].get(), xs[2].get(), xs[3].get()};
+    EXPECT_EQ(y1->support_vars(), s);
+    EXPECT_EQ(&y1->support_vars(), &y1->support_vars());
+    EXPECT_EQ(y1->degree(), 3);
+
+    EXPECT_EQ(_zero->degree(), 0);
+    EXPECT_EQ((~xs[5])->support_vars()[0], xs[5].get());
+
+    // Quantifying over variables outside the support
+    EXPECT_TRUE(y1->smoothing({xs[0], xs[9]})->equiv(y1));
+    EXPECT_EQ(y1->derivative({xs[1], xs[9]}), _zero);
+}
+
+
+TEST_F(BoolExprTest, StructuralHash)
+{
+    auto prev = enable_unique_table(false);
+
+    auto y0 = (xs[0] | ~xs[1]) & ite(xs[2], xs[3], _zero);
+    auto y1 = (xs[0] | ~xs[1]) & ite(xs[2], xs[3], _zero);
+    EXPECT_NE(y0, y1);
+    EXPECT_EQ(y0->structural_hash(), y1->structural_hash());
+    EXPECT_TRUE(y0->equals_structurally(y1));
+
+    // Argument order and kind matter
+    auto y2 = (~xs[1] | xs[0]) & ite(xs[2], xs[3], _zero);
+    auto y3 = (xs[0] & ~xs[1]) & ite(xs[2], xs[3], _zero);
+    EXPECT_NE(y0->structural_hash(), y2->structural_hash());
+    EXPECT_FALSE(y0->equals_structurally(y2));
+    EXPECT_FALSE(y0->equals_structurally(y3));
+    EXPECT_FALSE(xs[0]->equals_structurally(xs[1]));
+
+    // Literals in another Context match by name and polarity
+    Context other;
+    vector<var_t> zs;
+    for (auto name : {"p", "q", "s", "d1", "d0", "x_0", "x_1", "x_2", "x_3"}) {
+        zs.push_back(other.get_var(name));
+    }
+    auto z0 = (zs[5] | ~zs[6]) & ite(zs[7], zs[8], _zero);
+    EXPECT_TRUE(y0->equals_structurally(z0));
+    auto z1 = (zs[5] | zs[6]) & ite(zs[7], zs[8], _zero);
+    EXPECT_FALSE(y0->equals_structurally(z1));
+
+    Context renamed;
+    vector<var_t> ws;
+    for (auto name : {"p", "q", "s", "d1", "d0", "w_0", "w_1", "w_2", "w_3"}) {
+        ws.push_back(renamed.get_var(name));
+    }
+    auto w0 = (ws[5] | ~ws[6]) & ite(ws[7], ws[8], _zero);
+    EXPECT_EQ(y0->structural_hash(), w0->structural_hash());
+    EXPECT_FALSE(y0->equals_structurally(w0));
+
+    // Structural duplicates cancel
+    auto y4 = xor_({xs[0] & xs[1], xs[2], xs[0] & xs[1]})->simplify();
+    EXPECT_EQ(y4, xs[2]);
+
+    enable_unique_table(prev);
+}
@@ -0,0 +1,321 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class BddTest : public BoolExprTest {};
+
+
+TEST_F(BddTest, Basic)
+{
+    BddManager mgr;
+
+    EXPECT_TRUE(mgr.zero().is_zero());
+    EXPECT_TRUE(mgr.one().is_one());
+    EXPECT_EQ(~mgr.zero(), mgr.one());
+
+    auto a = mgr.var(xs[0]);
+    auto b = mgr.var(xs[1]);
+    EXPECT_EQ(mgr.num_vars(), 2);
+    EXPECT_EQ(a.size(), 2);
+    EXPECT_EQ(mgr.var(xs[0]), a);
+
+    // Complemented edges share nodes
+    EXPECT_EQ((~a).size(), 2);
+    EXPECT_EQ(~~a, a);
+
+    EXPECT_EQ(a & ~a, mgr.zero());
+    EXPECT_EQ(a | ~a, mgr.one());
+    EXPECT_EQ(a ^ a, mgr.zero());
+    EXPECT_EQ(a & b, b & a);
+    EXPECT_EQ(~(a & b), ~a | ~b);
+    EXPECT_EQ(mgr.ite(a, b, mgr.zero()), a & b);
+}
+
+
+// Equivalent expressions convert to the same edge
+TEST_F(BddTest, Canonical)
+{
+    BddManager mgr;
+
+    auto f = *mgr.to_bdd((xs[0] & xs[1]) | (~xs[0] & xs[2]));
+    auto g = *mgr.to_bdd(ite(xs[0], xs[1], xs[2]));
+    EXPECT_EQ(f, g);
+    EXPECT_NE(f, *mgr.to_bdd(ite(xs[0], xs[2], xs[1])));
+
+    vector<bx_t> args(xs.begin(), xs.begin() + 64);
+    auto y0 = *mgr.to_bdd(xor_(args));
+    auto y1 = *mgr.to_bdd(xnor(args));
+    EXPECT_EQ(y0, ~y1);
+    EXPECT_EQ(y0.size(), 65);
+    EXPECT_EQ(y0.count(), std::ldexp(1.0, 63));
+
+    EXPECT_EQ(*mgr.to_bdd(eq({xs[0], xs[1], xs[2]})),
+              *mgr.to_bdd((xs[0] & xs[1] & xs[2]) | (~xs[0] & ~xs[1] & ~xs[2])));
+    EXPECT_EQ(*mgr.to_bdd(impl(xs[0], xs[1])), *mgr.to_bdd(~xs[0] | xs[1]));
+    EXPECT_EQ(*mgr.to_bdd(nimpl(xs[0], xs[1])), *mgr.to_bdd(xs[0] & ~xs[1]));
+    EXPECT_EQ(*mgr.to_bdd(nor({xs[0], xs[1]})), *mgr.to_bdd(~xs[0] & ~xs[1]));
+}
+
+
+// Logical and illogical constants have no BDD
+TEST_F(BddTest, Unknown)
+{
+    BddManager mgr;
+
+    EXPECT_FALSE(mgr.to_bdd(_log));
+    EXPECT_FALSE(mgr.to_bdd(_ill));
+    EXPECT_FALSE(mgr.to_bdd(xs[0] | _log));
+    EXPECT_FALSE(mgr.to_bdd(ite(xs[0], xs[1] & _ill, xs[2])));
+
+    // Nothing is left referenced
+    mgr.gc();
+    EXPECT_EQ(mgr.num_nodes(), 0);
+
+    EXPECT_TRUE(mgr.to_bdd(xs[0] | _one));
+}
+
+
+TEST_F(BddTest, Convert)
+{
+    BddManager mgr;
+
+    auto y = (xs[0] ^ xs[3]) | ite(xs[2], ~xs[1], xs[4] & xs[5]);
+    auto f = *mgr.to_bdd(y);
+
+    auto z = mgr.from_bdd(f);
+    EXPECT_TRUE(z->equiv(y));
+    EXPECT_EQ(*mgr.to_bdd(z), f);
+
+    EXPECT_EQ(f.count(), truth_table(y)->count());
+
+    vector<var_t> support {xs[0], xs[1], xs[2], xs[3], xs[4], xs[5]};
+    EXPECT_EQ(f.support(), support);
+
+    auto soln = f.sat();
+    EXPECT_TRUE(soln.first);
+    EXPECT_EQ(*mgr.to_bdd(y->restrict_(*soln.second)), mgr.one());
+    EXPECT_FALSE((f & ~f).sat().first);
+}
+
+
+// Quantifiers agree with the expression versions
+TEST_F(BddTest, Quantify)
+{
+    BddManager mgr;
+
+    auto y = (xs[0] & xs[8]) | (xs[1] ^ xs[9]) | (xs[2] & ~xs[3]);
+    auto f = *mgr.to_bdd(y);
+
+    for (auto const & vs : vector<vector<var_t>> {{xs[0]}, {xs[9]},
+                                                  {xs[1], xs[8]},
+                                                  {xs[3], xs[0], xs[9]}}) {
+        EXPECT_EQ(f.smoothing(vs), *mgr.to_bdd(y->smoothing(vs)));
+        EXPECT_EQ(f.consensus(vs), *mgr.to_bdd(y->consensus(vs)));
+        EXPECT_EQ(f.derivative(vs), *mgr.to_bdd(y->derivative(vs)));
+    }
+
+    for (auto const & x : {xs[0], xs[3], xs[9]}) {
+        point_t p0 {{x, _zero}};
+        point_t p1 {{x, _one}};
+        EXPECT_EQ(f.cofactor(x, false), *mgr.to_bdd(y->restrict_(p0)));
+        EXPECT_EQ(f.cofactor(x, true), *mgr.to_bdd(y->restrict_(p1)));
+    }
+
+    // Outside the support
+    EXPECT_EQ(f.smoothing({xs[5]}), f);
+    EXPECT_TRUE(f.derivative({xs[5]}).is_zero());
+    EXPECT_TRUE(f.derivative({xs[50]}).is_zero());
+}
+
+
+TEST_F(BddTest, GC)
+{
+    BddManager mgr;
+
+    auto f = *mgr.to_bdd(xs[0] | xs[1]);
+    mgr.gc();
+    auto size = mgr.num_nodes();
+    EXPECT_EQ(size, 2);
+
+    for (int i = 0; i < 100; ++i) {
+        auto g = *mgr.to_bdd(xs[2*i] & xs[2*i+1]) | f;
+    }
+    EXPECT_GT(mgr.num_nodes(), size);
+
+    mgr.gc();
+    EXPECT_EQ(mgr.num_nodes(), size);
+
+    // Survivors are intact
+    EXPECT_EQ(f, *mgr.to_bdd(xs[1] | xs[0]));
+    auto g = f & *mgr.to_bdd(xs[2]);
+    EXPECT_EQ(g.count(), 3);
+}
+
+
+// A circuit with shared structure, where SAT would be slow
+TEST_F(BddTest, Adder)
+{
+    BddManager mgr;
+    size_t const n = 16;
+
+    // Ripple carry, with interleaved inputs
+    vector<bx_t> as, bs;
+    for (size_t i = 0; i < n; ++i) {
+        as.push_back(xs[2*i]);
+        bs.push_back(xs[2*i+1]);
+    }
+
+    bx_t c = _zero;
+    vector<bx_t> s0;
+    for (size_t i = 0; i < n; ++i) {
+        s0.push_back(xor_({as[i], bs[i], c}));
+        c = (as[i] & bs[i]) | (c & (as[i] ^ bs[i]));
+    }
+
+    // Sum of b + a, with majority carries
+    c = _zero;
+    vector<bx_t> s1;
+    for (size_t i = 0; i < n; ++i) {
+        s1.push_back(xs[2*i+1] ^ xs[2*i] ^ c);
+        c = (bs[i] & c) | (as[i] & c) | (as[i] & bs[i]);
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        EXPECT_EQ(*mgr.to_bdd(s0[i]), *mgr.to_bdd(s1[i]));
+    }
+}
+
+
+// (a0 & b0) | (a1 & b1) | ... is exponential with all a before all b,
+// and linear with each a next to its b.
+TEST_F(BddTest, Reorder)
+{
+    BddManager mgr;
+    size_t const n = 8;
+
+    bx_t y = _zero;
+    for (size_t i = 0; i < n; ++i) {
+        mgr.var(xs[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        mgr.var(xs[n+i]);
+        y = y | (xs[i] & xs[n+i]);
+    }
+
+    auto f = *mgr.to_bdd(y);
+    auto g = *mgr.to_bdd(xs[0] ^ xs[n+3]);
+    auto count = f.count();
+    EXPECT_EQ(f.size(), (size_t(1) << (n + 1)) - 1);
+
+    mgr.reorder_sift();
+    EXPECT_EQ(f.size(), 2 * n + 1);
+    EXPECT_EQ(f.count(), count);
+
+    // Each a is next to its b
+    auto order = mgr.get_order();
+    for (size_t i = 0; i < n; ++i) {
+        auto a = std::find(order.begin(), order.end(), xs[i]);
+        auto b = std::find(order.begin(), order.end(), xs[n+i]);
+        EXPECT_EQ(std::abs(a - b), 1);
+    }
+
+    // Every Bdd keeps its function
+    EXPECT_EQ(f, *mgr.to_bdd(y));
+    EXPECT_EQ(g, *mgr.to_bdd(xs[n+3] ^ xs[0]));
+    EXPECT_TRUE(mgr.from_bdd(f)->equiv(y));
+}
+
+
+TEST_F(BddTest, ReorderWindow)
+{
+    BddManager mgr;
+    size_t const n = 6;
+
+    bx_t y = _zero;
+    for (size_t i = 0; i < n; ++i) {
+        mgr.var(xs[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        y = y | (xs[i] & xs[n+i]);
+    }
+
+    auto f = *mgr.to_bdd(y);
+    auto size = f.size();
+
+    mgr.reorder_window();
+    EXPECT_LT(f.size(), size);
+    EXPECT_EQ(f, *mgr.to_bdd(y));
+    EXPECT_TRUE(mgr.from_bdd(f)->equiv(y));
+}
+
+
+// Growth during a conversion triggers sifting
+TEST_F(BddTest, AutoReorder)
+{
+    BddManager mgr;
+    size_t const n = 16;
+
+    EXPECT_FALSE(mgr.enable_auto_reorder());
+
+    bx_t y = _zero;
+    for (size_t i = 0; i < n; ++i) {
+        mgr.var(xs[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        y = y | (xs[i] & xs[n+i]);
+    }
+
+    // Without reordering, this has 2^17 - 1 nodes
+    auto f = *mgr.to_bdd(y);
+    EXPECT_LT(f.size(), 1000);
+
+    // Each pair is one at 1 of its 4 points
+    EXPECT_EQ(f.count(), std::pow(4.0, n) - std::pow(3.0, n));
+    EXPECT_EQ(*mgr.to_bdd(mgr.from_bdd(f)), f);
+
+    EXPECT_TRUE(mgr.enable_auto_reorder(false));
+}
+
+
+// Running out of time keeps every function intact
+TEST_F(BddTest, ReorderTimeLimit)
+{
+    BddManager mgr;
+    size_t const n = 8;
+
+    bx_t y = _zero;
+    for (size_t i = 0; i < n; ++i) {
+        mgr.var(xs[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        y = y | (xs[i] & xs[n+i]);
+    }
+
+    auto f = *mgr.to_bdd(y);
+    auto size = f.size();
+
+    mgr.set_reorder_time_limit(1e-9);
+    mgr.reorder_sift();
+    EXPECT_LE(f.size(), size);
+    EXPECT_EQ(f, *mgr.to_bdd(y));
+}
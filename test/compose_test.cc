@@ -43,6 +43,37 @@ TEST_F(ComposeTest, Basic)
 }
 
 
+TEST_F(ComposeTest, Dense)
+{
+    dense_var2bx_t var2bx((xs[7]->id >> 1) + 1);
+
+    // Substitutions are simultaneous
+    var2bx[xs[0]->id >> 1] = xs[1];
+    var2bx[xs[1]->id >> 1] = xs[0];
+
+    auto f0 = ~xs[0] | (xs[1] & xs[2]);
+    auto g0 = f0->compose_dense(&ctx, var2bx);
+    EXPECT_EQ(g0->to_string(), "Or(~x_1, And(x_0, x_2))");
+
+    // Shared sub-expressions stay shared
+    auto h = xs[2] ^ xs[3];
+    var2bx[xs[2]->id >> 1] = h;
+    bx_t f1 = xs[2];
+    for (int i = 0; i < 32; ++i) {
+        f1 = (f1 & xs[0]) | (f1 & ~xs[1]);
+    }
+    auto g1 = f1->compose_dense(&ctx, var2bx);
+    EXPECT_EQ(g1->dag_size(), f1->dag_size() + h->dag_size() - 1);
+
+    // Optionally simplify while rebuilding
+    var2bx[xs[3]->id >> 1] = _one;
+    auto f2 = (xs[3] | xs[4]) & xs[5];
+    EXPECT_EQ(f2->compose_dense(&ctx, var2bx)->to_string(),
+              "And(Or(1, x_4), x_5)");
+    EXPECT_EQ(f2->compose_dense(&ctx, var2bx, true), xs[5]);
+}
+
+
 TEST_F(ComposeTest, Restrict)
 {
     auto point = point_t {
@@ -62,3 +93,81 @@ TEST_F(ComposeTest, Restrict)
     auto g2 = f2->restrict_(point);
     EXPECT_EQ(g2, _one);
 }
+
+
+// Illogical wins over a value forced by another argument
+TEST_F(ComposeTest, RestrictIllogical)
+{
+    auto point = point_t {{xs[0], _one}, {xs[1], _zero}};
+
+    dense_point_t dense((xs[1]->id >> 1) + 1);
+    dense[xs[0]->id >> 1] = _one;
+    dense[xs[1]->id >> 1] = _zero;
+
+    vector<bx_t> fs {
+        or_({xs[0], _ill}),
+        or_({_ill, xs[0]}),
+        and_({xs[1], xs[2] | _ill}),
+        impl(xs[1], xs[2] & _ill),
+        ite(xs[0], xs[2], xs[3] & _ill),
+        ite(xs[1], xs[2] | _ill, xs[3]),
+        ~xs[1] | (xs[0] & ~xs[1]) | _ill,
+    };
+
+    for (auto const & f : fs) {
+        EXPECT_EQ(f->restrict_(point), _ill);
+        EXPECT_EQ(f->restrict_dense(&ctx, dense), _ill);
+        EXPECT_EQ(f->simplify(), _ill);
+    }
+
+    // Otherwise, the forced value stands
+    EXPECT_EQ(or_({xs[0], _log})->restrict_(point), _one);
+    EXPECT_EQ(ite(xs[0], xs[2], _log)->restrict_(point), xs[2]);
+    EXPECT_EQ(and_({xs[1], xs[2] ^ xs[3], xs[4] | _ill, xs[5]})
+                  ->restrict_dense(&ctx, dense), _ill);
+    EXPECT_EQ(and_({xs[1], xs[2] ^ xs[3], xs[4] | _log, xs[5]})
+                  ->restrict_dense(&ctx, dense), _zero);
+
+    // A point can make a literal illogical
+    auto ill_point = point_t {{xs[0], _one}, {xs[3], _ill}};
+    EXPECT_EQ(or_({xs[0], xs[2] ^ xs[3]})->restrict_(ill_point), _ill);
+    EXPECT_EQ(or_({xs[0], xs[2] ^ xs[4]})->restrict_(ill_point), _one);
+    dense[xs[1]->id >> 1] = _ill;
+    EXPECT_EQ(or_({xs[0], xs[1] & xs[2]})->restrict_dense(&ctx, dense), _ill);
+}
+
+
+TEST_F(ComposeTest, RestrictDense)
+{
+    size_t n = (xs[7]->id >> 1) + 1;
+
+    dense_point_t point(n);
+    point[xs[0]->id >> 1] = _zero;
+    point[xs[1]->id >> 1] = _one;
+
+    EXPECT_EQ(xs[0]->restrict_dense(&ctx, point), _zero);
+    EXPECT_EQ((~xs[0])->restrict_dense(&ctx, point), _one);
+    EXPECT_EQ(xs[2]->restrict_dense(&ctx, point), xs[2]);
+
+    // Variables of other contexts are free
+    Context other;
+    auto y = other.get_var("x_0");
+    EXPECT_EQ(y->restrict_dense(&ctx, point), y);
+
+    auto f0 = ite(xs[0], xs[2], xs[1] & ~xs[3]) ^ (xs[4] | xs[1]);
+    EXPECT_TRUE(f0->restrict_dense(&ctx, point)->equiv(xs[3]));
+
+    auto f1 = impl(xs[2], xs[3]) & (xs[0] | xs[2]) & nor({xs[3], xs[1]});
+    EXPECT_EQ(f1->restrict_dense(&ctx, point), _zero);
+
+    // Same as restrict_ for every point
+    auto f2 = ~xs[0] | ((xs[1] & ~xs[2]) ^ xs[3]) | nand({xs[2], ~xs[3]});
+    vector<var_t> vars {xs[0], xs[1], xs[2], xs[3]};
+    for (auto it = points_iter(vars); it != points_iter(); ++it) {
+        dense_point_t dense(n);
+        for (auto const & pair : *it) {
+            dense[pair.first->id >> 1] = pair.second;
+        }
+        EXPECT_EQ(f2->restrict_dense(&ctx, dense), f2->restrict_(*it));
+    }
+}
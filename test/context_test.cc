@@ -0,0 +1,113 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class ContextTest : public BoolExprTest {};
+
+
+TEST_F(ContextTest, GetVars)
+{
+    auto a = ctx.get_vars("a", {{0, 2}, {1, 4}});
+    EXPECT_EQ(a.size(), 6);
+
+    // Contiguous ids, in row-major order
+    for (size_t i = 1; i < a.size(); ++i) {
+        EXPECT_EQ(a[i]->id, a[0]->id + 2 * i);
+    }
+
+    EXPECT_EQ(a[0]->to_string(), "a[0,1]");
+    EXPECT_EQ(a[2]->to_string(), "a[0,3]");
+    EXPECT_EQ(a[3]->to_string(), "a[1,1]");
+    EXPECT_EQ((~a[5])->to_string(), "~a[1,3]");
+
+    // Names resolve to block variables
+    EXPECT_EQ(ctx.get_var("a[1,2]"), a[4]);
+    EXPECT_NE(ctx.get_var("a[01,2]"), a[4]);
+    EXPECT_NE(ctx.get_var("a[1,0]"), a[3]);
+
+    // Same block again
+    auto b = ctx.get_vars("a", {{0, 2}, {1, 4}});
+    EXPECT_EQ(b, a);
+
+    EXPECT_EQ(ctx.get_vars("c", {{0, 0}}).size(), 0);
+}
+
+
+TEST_F(ContextTest, Overlap)
+{
+    auto x = ctx.get_var("b[1]");
+
+    auto b = ctx.get_vars("b", {{0, 3}});
+    EXPECT_EQ(b[1], x);
+    EXPECT_EQ(b[2]->to_string(), "b[2]");
+
+    auto c = ctx.get_vars("c", {{0, 4}});
+    auto d = ctx.get_vars("c", {{2, 6}});
+    EXPECT_EQ(d[0], c[2]);
+    EXPECT_EQ(d[1], c[3]);
+    EXPECT_EQ(d[2]->to_string(), "c[4]");
+    EXPECT_EQ(ctx.get_var("c[5]"), d[3]);
+}
+
+
+TEST_F(ContextTest, Threads)
+{
+    auto prev = enable_unique_table();
+
+    size_t const N = 4;
+    std::vector<std::vector<var_t>> vars(N);
+    std::vector<bx_t> ys(N);
+    std::vector<std::string> strs(N);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < N; ++t) {
+        threads.emplace_back([this, t, &vars, &ys, &strs] {
+            for (size_t i = 0; i < 256; ++i) {
+                vars[t].push_back(ctx.get_var("t_" + std::to_string(i)));
+            }
+            auto b = ctx.get_vars("tb", {{0, 64}});
+            bx_t y = ~b[0] & vars[t][0];
+            for (size_t i = 1; i < 64; ++i) {
+                y = y | (~b[i] & vars[t][i]);
+            }
+            ys[t] = y;
+            // Plain and block names, formatted concurrently
+            strs[t] = y->to_string();
+        });
+    }
+
+    for (auto & thread : threads) {
+        thread.join();
+    }
+
+    // Every thread sees the same variables, and builds the same nodes
+    for (size_t t = 1; t < N; ++t) {
+        EXPECT_EQ(vars[t], vars[0]);
+        EXPECT_EQ(ys[t], ys[0]);
+        EXPECT_EQ(strs[t], strs[0]);
+    }
+    EXPECT_EQ(vars[0][255]->to_string(), "t_255");
+
+    enable_unique_table(prev);
+}
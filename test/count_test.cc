@@ -68,3 +68,21 @@ TEST_F(CountTest, Operators)
     EXPECT_EQ(y2->depth(), 4);
     EXPECT_EQ(y2->size(), 29);
 }
+
+
+TEST_F(CountTest, Shared)
+{
+    auto y0 = ~xs[0] | ((xs[1] & ~xs[2]) ^ xs[3]);
+    EXPECT_EQ(y0->dag_size(), 7);
+    EXPECT_EQ(xs[0]->dag_size(), 1);
+
+    // Each level refers to the one below twice
+    bx_t y1 = xs[0];
+    for (size_t i = 1; i <= 40; ++i) {
+        y1 = ite(xs[i], y1, ~y1);
+    }
+
+    EXPECT_EQ(y1->depth(), 40);
+    EXPECT_EQ(y1->size(), UINT32_MAX);
+    EXPECT_LT(y1->dag_size(), 200);
+}
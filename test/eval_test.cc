@@ -0,0 +1,201 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <algorithm>
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+using boost::static_pointer_cast;
+
+
+class EvalTest : public BoolExprTest {};
+
+
+TEST_F(EvalTest, Atoms)
+{
+    point_t point {{xs[0], _one}};
+
+    EXPECT_EQ(_zero->eval(point), _zero);
+    EXPECT_EQ(_one->eval(point), _one);
+    EXPECT_EQ(_log->eval(point), _log);
+    EXPECT_EQ(_ill->eval(point), _ill);
+    EXPECT_EQ(xs[0]->eval(point), _one);
+    EXPECT_EQ((~xs[0])->eval(point), _zero);
+
+    // Free variables are X
+    EXPECT_EQ(xs[1]->eval(point), _log);
+    EXPECT_EQ((~xs[1])->eval(point), _log);
+}
+
+
+// Evaluation agrees with restrict_ at every point
+TEST_F(EvalTest, Restrict)
+{
+    vector<bx_t> fs {
+        nor({xs[0], ~xs[1], xs[2]}),
+        or_({xs[0], ~xs[1], xs[2]}),
+        nand({xs[0], ~xs[1], xs[2]}),
+        and_({xs[0], ~xs[1], xs[2]}),
+        xnor({xs[0], ~xs[1], xs[2]}),
+        xor_({xs[0], ~xs[1], xs[2]}),
+        neq({xs[0], ~xs[1], xs[2]}),
+        eq({xs[0], ~xs[1], xs[2]}),
+        nimpl(xs[0], xs[1] | xs[2]),
+        impl(xs[0], xs[1] | xs[2]),
+        nite(xs[0], xs[1] ^ xs[2], ~xs[2]),
+        ite(xs[0], xs[1] ^ xs[2], ~xs[2]),
+        ite(xs[0], xs[1], xs[1]) | (xs[2] & ~xs[0]),
+    };
+
+    vector<var_t> vars {xs[0], xs[1], xs[2]};
+    vector<bool> bits((xs[2]->id >> 1) + 1);
+
+    for (auto const & f : fs) {
+        for (auto it = points_iter(vars); it != points_iter(); ++it) {
+            auto ans = f->restrict_(*it);
+            EXPECT_EQ(f->eval(*it), ans);
+
+            for (auto const & pair : *it) {
+                bits[pair.first->id >> 1] = IS_ONE(pair.second);
+            }
+            EXPECT_EQ(f->eval(&ctx, bits), ans);
+        }
+    }
+}
+
+
+TEST_F(EvalTest, Logical)
+{
+    point_t point {{xs[0], _one}, {xs[1], _zero}};
+
+    // The value doesn't depend on x_2
+    EXPECT_EQ((xs[0] | xs[2])->eval(point), _one);
+    EXPECT_EQ((xs[1] & xs[2])->eval(point), _zero);
+    EXPECT_EQ(impl(xs[1], xs[2])->eval(point), _one);
+    EXPECT_EQ(ite(xs[0], xs[1], xs[2])->eval(point), _zero);
+    EXPECT_EQ(ite(xs[2], xs[0], ~xs[1])->eval(point), _one);
+
+    // The value depends on x_2
+    EXPECT_EQ((xs[1] | xs[2])->eval(point), _log);
+    EXPECT_EQ((xs[0] ^ xs[2])->eval(point), _log);
+    EXPECT_EQ(eq({xs[0], xs[2]})->eval(point), _log);
+    EXPECT_EQ(ite(xs[2], xs[0], xs[1])->eval(point), _log);
+
+    // Variables of other contexts are X
+    Context other;
+    auto y = other.get_var("x_0");
+    vector<bool> bits((xs[0]->id >> 1) + 1, true);
+    EXPECT_EQ((xs[0] & y)->eval(&ctx, bits), _log);
+    EXPECT_EQ((xs[0] | y)->eval(&ctx, bits), _one);
+}
+
+
+TEST_F(EvalTest, NoNodes)
+{
+    auto f = (xs[0] | xs[1]) & ite(xs[2], xs[3], ~xs[0]);
+    point_t point {{xs[0], _one}, {xs[1], _zero}, {xs[2], _one}};
+
+    NodePool pool;
+    NodePoolScope scope(pool);
+
+    EXPECT_EQ(f->eval(point), _log);
+    EXPECT_EQ(pool.live(), 0);
+}
+
+
+// The value doesn't depend on the argument order,
+// and illogical wins over a deciding argument, as in simplify.
+TEST_F(EvalTest, Illogical)
+{
+    point_t point {{xs[0], _one}, {xs[1], _zero}, {xs[2], _log}};
+
+    using nary_t = bx_t (*)(vector<bx_t> const &);
+    vector<nary_t> nops {nor, or_, nand, and_, xnor, xor_, neq, eq};
+
+    vector<bx_t> vals {xs[0], xs[1], xs[2], _ill};
+    vector<size_t> idx {0, 1, 2, 3};
+    do {
+        vector<bx_t> args;
+        for (auto i : idx) {
+            args.push_back(vals[i]);
+        }
+        for (auto nop : nops) {
+            auto f = nop(args);
+            EXPECT_EQ(f->eval(point), _ill);
+            EXPECT_EQ(f->eval(point), f->restrict_(point));
+        }
+    } while (std::next_permutation(idx.begin(), idx.end()));
+
+    EXPECT_EQ(or_({xs[0], _ill})->eval(point), _ill);
+    EXPECT_EQ(or_({_ill, xs[0]})->eval(point), _ill);
+    EXPECT_EQ(and_({xs[1], xs[2] | _ill})->eval(point), _ill);
+    EXPECT_EQ(xor_({xs[2], _ill})->eval(point), _ill);
+    EXPECT_EQ(impl(xs[1], _ill)->eval(point), _ill);
+    EXPECT_EQ(ite(xs[0], xs[0], _ill)->eval(point), _ill);
+    EXPECT_EQ(ite(xs[1], _ill, xs[0])->eval(point), _ill);
+
+    // Every pair of values, in both orders
+    vector<bx_t> consts {_zero, _one, _log, _ill, xs[0], xs[1], xs[2]};
+    for (auto const & a : consts) {
+        for (auto const & b : consts) {
+            for (auto nop : nops) {
+                EXPECT_EQ(nop({a, b})->eval(point), nop({b, a})->eval(point));
+                EXPECT_EQ(nop({a, b})->eval(point),
+                          nop({a, b})->restrict_(point));
+            }
+            EXPECT_EQ(impl(a, b)->eval(point), impl(a, b)->restrict_(point));
+            for (auto const & c : consts) {
+                EXPECT_EQ(ite(a, b, c)->eval(point),
+                          ite(a, b, c)->restrict_(point));
+            }
+        }
+    }
+}
+
+
+// A deciding argument skips the rest, unless something illogical is left
+TEST_F(EvalTest, ShortCircuit)
+{
+    auto g = xs[2] ^ xs[3];
+    EXPECT_FALSE(static_pointer_cast<Operator const>(g)->has_ill());
+    auto h = static_pointer_cast<Operator const>(and_({xs[0], g | _ill}));
+    EXPECT_TRUE(h->has_ill());
+
+    point_t point {{xs[0], _one}, {xs[1], _zero}, {xs[2], _log}};
+    EXPECT_EQ(or_({xs[0], g, g & xs[1]})->eval(point), _one);
+    EXPECT_EQ(or_({xs[0], g, g & _ill})->eval(point), _ill);
+    EXPECT_EQ(and_({xs[1], g, h})->eval(point), _ill);
+    EXPECT_EQ(impl(xs[1], g)->eval(point), _one);
+    EXPECT_EQ(impl(xs[1], h)->eval(point), _ill);
+    EXPECT_EQ(ite(xs[0], xs[1], g)->eval(point), _zero);
+    EXPECT_EQ(ite(xs[1], g, xs[0])->eval(point), _one);
+    EXPECT_EQ(ite(xs[0], xs[1], h)->eval(point), _ill);
+    EXPECT_EQ(ite(xs[1], h, xs[0])->eval(point), _ill);
+
+    // A point can make a literal illogical
+    point_t ill_point {{xs[0], _one}, {xs[3], _ill}};
+    EXPECT_EQ(or_({xs[0], xs[3]})->eval(ill_point), _ill);
+    EXPECT_EQ(ite(xs[0], xs[0], ~xs[3])->eval(ill_point), _ill);
+
+    vector<bool> bits((xs[3]->id >> 1) + 1);
+    bits[xs[0]->id >> 1] = true;
+    EXPECT_EQ(or_({xs[0], g})->eval(&ctx, bits), _one);
+    EXPECT_EQ(or_({xs[0], g | _ill})->eval(&ctx, bits), _ill);
+}
@@ -78,16 +78,16 @@ TEST_F(FlattenTest, Xor)
 
         if (i >= 2) {
             EXPECT_TRUE(y0_cnf->is_cnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y0_cnf)->args.size(), (1<<(i-1)));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y0_cnf)->args.size(), (1<<(i-1)));
 
             EXPECT_TRUE(y0_dnf->is_dnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y0_dnf)->args.size(), (1<<(i-1)));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y0_dnf)->args.size(), (1<<(i-1)));
 
             EXPECT_TRUE(y1_cnf->is_cnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y1_cnf)->args.size(), (1<<(i-1)));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y1_cnf)->args.size(), (1<<(i-1)));
 
             EXPECT_TRUE(y1_dnf->is_dnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y1_dnf)->args.size(), (1<<(i-1)));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y1_dnf)->args.size(), (1<<(i-1)));
         }
     }
 }
@@ -124,16 +124,16 @@ TEST_F(FlattenTest, Equal)
 
         if (i >= 2) {
             EXPECT_TRUE(y0_cnf->is_cnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y0_cnf)->args.size(), i*(i-1));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y0_cnf)->args.size(), i*(i-1));
 
             EXPECT_TRUE(y0_dnf->is_dnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y0_dnf)->args.size(), 2);
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y0_dnf)->args.size(), 2);
 
             EXPECT_TRUE(y1_cnf->is_cnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y1_cnf)->args.size(), 2);
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y1_cnf)->args.size(), 2);
 
             EXPECT_TRUE(y1_dnf->is_dnf());
-            EXPECT_EQ(std::static_pointer_cast<Operator const>(y1_dnf)->args.size(), i*(i-1));
+            EXPECT_EQ(boost::static_pointer_cast<Operator const>(y1_dnf)->args.size(), i*(i-1));
         }
     }
 }
@@ -238,3 +238,54 @@ TEST_F(FlattenTest, All)
     EXPECT_TRUE(y1_cnf->is_cnf() && y1_cnf->equiv(y1));
     EXPECT_TRUE(y1_dnf->is_dnf() && y1_dnf->equiv(y1));
 }
+
+
+// Shared sub-expressions are only flattened once
+TEST_F(FlattenTest, Shared)
+{
+    bx_t y = xs[0];
+    for (int i = 1; i <= 32; ++i) {
+        y = (y & xs[i]) | (y & xs[i+1]);
+    }
+
+    auto y_cnf = y->to_cnf();
+    EXPECT_TRUE(y_cnf->is_cnf());
+
+    // x_0 & (x_1 | x_2) & (x_2 | x_3) & ...
+    auto op = boost::static_pointer_cast<Operator const>(y_cnf);
+    EXPECT_EQ(op->args.size(), 33);
+
+    point_t point {{xs[0], _one}};
+    for (int i = 1; i <= 33; ++i) {
+        if (i % 2) {
+            point.insert({xs[i], _one});
+        }
+        else {
+            point.insert({xs[i], _zero});
+        }
+    }
+    EXPECT_EQ(y_cnf->restrict_(point), _one);
+    EXPECT_EQ(y->restrict_(point), _one);
+}
+
+
+// Products with both x and ~x are pruned while multiplying out.
+// (x_0 ^ x_1) & (x_1 ^ x_2) & ... has two terms in DNF,
+// but about 2^32 products without the pruning.
+TEST_F(FlattenTest, Complements)
+{
+    vector<bx_t> args;
+    for (int i = 0; i < 16; ++i) {
+        args.push_back(xs[i] | xs[i+1]);
+        args.push_back(~xs[i] | ~xs[i+1]);
+    }
+    auto y = and_(std::move(args));
+
+    auto y_dnf = y->to_dnf();
+    EXPECT_TRUE(y_dnf->is_dnf());
+
+    auto op = boost::static_pointer_cast<Operator const>(y_dnf);
+    EXPECT_EQ(op->args.size(), 2);
+    EXPECT_EQ(op->args[0]->support().size(), 17);
+    EXPECT_EQ(op->args[1]->support().size(), 17);
+}
@@ -140,3 +140,53 @@ TEST_F(IterTest, CofactorIter)
     for (auto it = cf_iter(f, vars); it != cf_iter(); ++it)
         EXPECT_TRUE((*it)->equiv(ans[i++]));
 }
+
+
+// Transforms walk the DAG with an explicit stack,
+// so a very deep expression does not overflow the call stack.
+TEST_F(IterTest, DeepChain)
+{
+    bx_t y = xs[0];
+    for (int i = 1; i <= 10000; ++i) {
+        auto x = xs[i % 8];
+        switch (i % 6) {
+            case 0: y = nor({y, x}); break;
+            case 1: y = xnor({x, y}); break;
+            case 2: y = impl(y, x); break;
+            case 3: y = neq({y, x}); break;
+            case 4: y = ite(x, y, xs[(i + 1) % 8]); break;
+            case 5: y = ~ite(x, xs[(i + 3) % 8], y); break;
+        }
+    }
+
+    EXPECT_EQ(y->depth(), 10000);
+
+    auto y_binop = y->to_binop();
+    auto y_posop = y->to_posop();
+    auto y_latop = y->to_latop();
+    auto y_simple = y->simplify();
+
+    point_t point;
+    for (int i = 0; i < 8; ++i) {
+        if (i % 3 == 0) {
+            point.insert({xs[i], _one});
+        }
+        else {
+            point.insert({xs[i], _zero});
+        }
+    }
+
+    auto ans = y->restrict_(point);
+    EXPECT_TRUE(IS_CONST(ans));
+    EXPECT_EQ(y_binop->restrict_(point), ans);
+    EXPECT_EQ(y_posop->restrict_(point), ans);
+    EXPECT_EQ(y_latop->restrict_(point), ans);
+    EXPECT_EQ(y_simple->restrict_(point), ans);
+
+    var2bx_t var2bx;
+    for (int i = 0; i < 8; ++i) {
+        var2bx.insert({xs[i], ~xs[i + 8]});
+    }
+    auto z = y->compose(var2bx);
+    EXPECT_EQ(z->depth(), 10000);
+}
@@ -0,0 +1,103 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class PoolTest : public BoolExprTest {};
+
+
+TEST_F(PoolTest, Basic)
+{
+    NodePool pool;
+    EXPECT_EQ(pool.live(), 0);
+
+    {
+        NodePoolScope scope(pool);
+
+        auto y0 = ~xs[0] | xs[1];
+        auto y1 = ite(xs[0], y0, xs[2] & xs[3]);
+        EXPECT_GE(pool.live(), 3);
+        EXPECT_GT(pool.capacity(), 0);
+
+        auto y2 = y1->simplify();
+        EXPECT_TRUE(y1->equiv(y2));
+    }
+
+    // Everything built inside the scope has been dropped
+    EXPECT_EQ(pool.live(), 0);
+
+    // Outside the scope, nodes come from the heap
+    auto y3 = xs[0] & xs[1];
+    EXPECT_EQ(pool.live(), 0);
+}
+
+
+TEST_F(PoolTest, Reuse)
+{
+    NodePool pool;
+    NodePoolScope scope(pool);
+
+    for (int i = 0; i < 1000; ++i) {
+        auto y = xor_({xs[i], xs[i+1], xs[i+2]});
+    }
+
+    EXPECT_EQ(pool.live(), 0);
+    EXPECT_EQ(pool.capacity(), 64 * 1024);
+}
+
+
+TEST_F(PoolTest, Outlive)
+{
+    bx_t y;
+
+    {
+        NodePool pool;
+        NodePoolScope scope(pool);
+        y = (xs[0] | xs[1]) & (xs[2] | xs[3]);
+    }
+
+    // Nodes stay valid after the pool is dropped
+    EXPECT_EQ(y->to_string(), "And(Or(x_0, x_1), Or(x_2, x_3))");
+}
+
+
+// The background thread hands pooled nodes back to the calling thread
+TEST_F(PoolTest, Background)
+{
+    NodePool pool;
+    auto prev = enable_background_destroy(true);
+
+    for (int i = 0; i < 100; ++i) {
+        bx_t y0, y1;
+        {
+            NodePoolScope scope(pool);
+            y0 = xs[i] | xs[i+1];
+            y1 = ite(xs[i], y0, xs[i+2] & xs[i+3]);
+        }
+        // Unpooled nodes over pooled ones
+        auto y2 = impl(y1, xs[i+4]) ^ y0;
+        y0 = y1 = nullptr;
+        EXPECT_GE(pool.live(), 3);
+    }
+
+    wait_background_destroy();
+    EXPECT_EQ(pool.live(), 0);
+
+    enable_background_destroy(prev);
+}
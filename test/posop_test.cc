@@ -64,3 +64,18 @@ TEST_F(PosOpTest, TwoLevel)
     auto y5 = ite(~(xs[0] & xs[1]), ~(xs[2] & xs[3]), ~(xs[4] & xs[5]));
     EXPECT_EQ(y5->to_posop()->to_string(), "IfThenElse(Or(~x_0, ~x_1), Or(~x_2, ~x_3), Or(~x_4, ~x_5))");
 }
+
+
+// Positive operators come back unchanged, and shared nodes stay shared
+TEST_F(PosOpTest, Reuse)
+{
+    auto y0 = (xs[0] | ~xs[1]) & ite(xs[2], xs[3], xs[4]);
+    EXPECT_EQ(y0->to_posop(), y0);
+
+    auto a = xs[0] | xs[1];
+    auto y1 = ~a & a;
+    auto p1 = y1->to_posop();
+    EXPECT_EQ(p1->to_string(), "And(And(~x_0, ~x_1), Or(x_0, x_1))");
+    auto op = boost::static_pointer_cast<Operator const>(p1);
+    EXPECT_EQ(op->args[1], a);
+}
@@ -0,0 +1,91 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+using boost::static_pointer_cast;
+
+
+class RefCountTest : public BoolExprTest {};
+
+
+TEST_F(RefCountTest, Lifetime)
+{
+    auto prev = enable_unique_table(true);
+
+    auto n = unique_table_size();
+    {
+        auto y0 = xs[0] | xs[1];
+        auto y1 = y0;
+        EXPECT_EQ(y0->shared_from_this(), y1);
+
+        // The last reference keeps the node alive
+        y0.reset();
+        EXPECT_EQ(unique_table_size(), n + 1);
+        EXPECT_EQ(y1->to_string(), "Or(x_0, x_1)");
+    }
+    EXPECT_EQ(unique_table_size(), n);
+
+    enable_unique_table(prev);
+}
+
+
+TEST_F(RefCountTest, Hash)
+{
+    std::unordered_set<bx_t> s {xs[0], xs[0], ~xs[0]};
+    EXPECT_EQ(s.size(), 2);
+
+    auto x = static_pointer_cast<Variable const>(xs[0]);
+    std::unordered_map<var_t, int> m {{x, 42}};
+    EXPECT_EQ(m[x], 42);
+}
+
+
+TEST_F(RefCountTest, DeepChain)
+{
+    auto prev = enable_unique_table(true);
+    auto n = unique_table_size();
+
+    // Dropping a very deep chain does not recurse
+    {
+        bx_t y = xs[0];
+        for (int i = 1; i <= 100000; ++i) {
+            y = (i % 2) ? (y | xs[i % 16]) : (y & xs[i % 16]);
+        }
+        EXPECT_EQ(unique_table_size(), n + 100000);
+    }
+    EXPECT_EQ(unique_table_size(), n);
+
+    // Or on a background thread
+    EXPECT_FALSE(enable_background_destroy(true));
+    {
+        bx_t y = xs[0];
+        for (int i = 1; i <= 100000; ++i) {
+            y = impl(y, xs[i % 16]);
+        }
+    }
+    wait_background_destroy();
+    EXPECT_EQ(unique_table_size(), n);
+    EXPECT_TRUE(enable_background_destroy(false));
+
+    enable_unique_table(prev);
+}
@@ -13,12 +13,17 @@
 // limitations under the License.
 
 
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
 #include "boolexpr/boolexpr.h"
 #include "boolexprtest.h"
 
 
+using boost::static_pointer_cast;
+
+
 class SimplifyTest : public BoolExprTest {};
 
 
@@ -539,3 +544,46 @@ TEST_F(SimplifyTest, IfThenElseUnknowns)
     EXPECT_EQ(ite_s(xs[0], xs[1], _log)->to_string(), "X");
     EXPECT_EQ(ite_s(_log, xs[0], xs[1])->to_string(), "X");
 }
+
+
+TEST_F(SimplifyTest, Shared)
+{
+    auto y0 = or_({xs[0], xs[1], _zero});
+    auto y1 = and_({y0, xs[2]});
+    auto y2 = xor_({y0, xs[3]});
+
+    auto z1 = y1->simplify();
+    auto z2 = y2->simplify();
+
+    // Both parents refer to the same simplified child
+    auto z0 = y0->simplify();
+    auto a1 = static_pointer_cast<Operator const>(z1);
+    auto a2 = static_pointer_cast<Operator const>(z2);
+    EXPECT_NE(std::find(a1->args.cbegin(), a1->args.cend(), z0), a1->args.cend());
+    EXPECT_NE(std::find(a2->args.cbegin(), a2->args.cend(), z0), a2->args.cend());
+
+    // The result is remembered
+    EXPECT_EQ(y1->simplify(), z1);
+
+    // Each level refers to the one below twice
+    bx_t y3 = xs[0];
+    for (size_t i = 1; i <= 40; ++i) {
+        y3 = ite(xs[i], y3, or_({y3, _zero}));
+    }
+    EXPECT_LT(y3->simplify()->dag_size(), 200);
+}
+
+
+TEST_F(SimplifyTest, ArgOrder)
+{
+    auto y0 = or_s({xs[3], xs[1], or_s({xs[4], xs[0]}), xs[2], xs[1]});
+    EXPECT_EQ(y0->to_string(), "Or(x_0, x_1, x_2, x_3, x_4)");
+
+    auto y1 = and_s({xs[5], and_s({xs[2], xs[6]}), and_s({xs[1], xs[6]})});
+    EXPECT_EQ(y1->to_string(), "And(x_1, x_2, x_5, x_6)");
+
+    auto y2 = xor_s({xs[2], xs[0], xor_s({xs[1], xs[2], xs[3]})});
+    EXPECT_EQ(y2->to_string(), "Xor(x_0, x_1, x_3)");
+
+    EXPECT_EQ(or_s({xs[2], or_s({xs[0], ~xs[2]})})->to_string(), "1");
+}
@@ -0,0 +1,189 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class SimulateTest : public BoolExprTest {};
+
+
+// Every width agrees with eval, pattern by pattern
+TEST_F(SimulateTest, Eval)
+{
+    auto s = xs[0] ^ xs[1] ^ xs[2];
+    Array fs {
+        s,
+        xs[1],
+        ~xs[3],
+        nor({xs[0], ~xs[1], xs[2]}),
+        nand({xs[0], ~xs[1], s}),
+        xnor({xs[0], ~xs[1], xs[3]}),
+        neq({xs[0], ~xs[1], xs[2]}),
+        eq({xs[0], s, xs[3]}),
+        nimpl(xs[0], xs[1] | xs[2]),
+        impl(s, xs[1] & xs[4]),
+        nite(xs[0], xs[1] ^ xs[2], ~xs[3]),
+        ite(xs[4], xs[1] ^ xs[2], ~xs[2] | _one),
+    };
+
+    Tape tape(fs);
+    auto const & inputs = tape.get_inputs();
+    ASSERT_EQ(inputs.size(), 5);
+
+    // Not a multiple of any block, to cover the tail
+    size_t n = 11;
+    std::mt19937_64 rng(42);
+    vector<vector<uint64_t>> words(inputs.size(), vector<uint64_t>(n));
+    for (auto & xs : words) {
+        for (auto & w : xs) {
+            w = rng();
+        }
+    }
+
+    for (size_t width : {64, 256, 512, 0}) {
+        auto ys = tape.simulate(words, width);
+        ASSERT_EQ(ys.size(), fs.size());
+
+        for (size_t k = 0; k < 64 * n; ++k) {
+            vector<bool> bits;
+            for (auto const & xs : words) {
+                bits.push_back((xs[k / 64] >> (k % 64)) & 1);
+            }
+            auto ans = tape.eval(bits);
+            for (size_t j = 0; j < fs.size(); ++j) {
+                bool y = (ys[j][k / 64] >> (k % 64)) & 1;
+                EXPECT_EQ(y, IS_ONE(ans[j]));
+            }
+        }
+    }
+}
+
+
+TEST_F(SimulateTest, Constants)
+{
+    Array fs {_zero, _one, ~xs[0] & _one};
+    Tape tape(fs);
+
+    vector<vector<uint64_t>> words {{0x00FF00FF00FF00FFULL}};
+    auto ys = tape.simulate(words);
+    EXPECT_EQ(ys[0][0], 0);
+    EXPECT_EQ(ys[1][0], ~uint64_t(0));
+    EXPECT_EQ(ys[2][0], 0xFF00FF00FF00FF00ULL);
+}
+
+
+// Every width agrees with eval on all points of zero, one, and logical
+TEST_F(SimulateTest, Ternary)
+{
+    auto s = xs[0] ^ xs[1] ^ xs[2];
+    Array fs {
+        s,
+        ~xs[3],
+        nor({xs[0], ~xs[1], xs[2]}),
+        nand({xs[0], ~xs[1], s}),
+        xnor({xs[0], ~xs[1], xs[3]}),
+        neq({xs[0], ~xs[1], xs[2]}),
+        eq({xs[0], s, xs[3]}),
+        nimpl(xs[0], xs[1] | xs[2]),
+        impl(s, xs[1] & xs[4]),
+        nite(xs[0], xs[1] ^ xs[2], ~xs[3]),
+        ite(xs[4], xs[1] | _log, ~xs[2]),
+        ite(xs[4], xs[1], xs[1]),
+    };
+
+    Tape tape(fs);
+    auto const & inputs = tape.get_inputs();
+    ASSERT_EQ(inputs.size(), 5);
+
+    // Pattern k has input i equal to digit i of k in base 3
+    size_t npoints = 3 * 3 * 3 * 3 * 3;
+    size_t n = (npoints + 63) / 64;
+    vector<vector<uint64_t>> ones(inputs.size(), vector<uint64_t>(n));
+    vector<vector<uint64_t>> zeros(inputs.size(), vector<uint64_t>(n));
+    vector<point_t> points(npoints);
+    for (size_t k = 0; k < npoints; ++k) {
+        auto d = k;
+        for (size_t i = 0; i < inputs.size(); ++i, d /= 3) {
+            auto bit = uint64_t(1) << (k % 64);
+            if (d % 3 == 0) {
+                zeros[i][k / 64] |= bit;
+                points[k].insert({inputs[i], _zero});
+            }
+            else if (d % 3 == 1) {
+                ones[i][k / 64] |= bit;
+                points[k].insert({inputs[i], _one});
+            }
+            else {
+                ones[i][k / 64] |= bit;
+                zeros[i][k / 64] |= bit;
+                points[k].insert({inputs[i], _log});
+            }
+        }
+    }
+
+    for (size_t width : {64, 256, 512}) {
+        auto ys = tape.simulate_ternary(ones, zeros, width);
+        ASSERT_EQ(ys.first.size(), fs.size());
+
+        for (size_t k = 0; k < npoints; ++k) {
+            for (size_t j = 0; j < fs.size(); ++j) {
+                bool h = (ys.first[j][k / 64] >> (k % 64)) & 1;
+                bool l = (ys.second[j][k / 64] >> (k % 64)) & 1;
+                auto ans = fs[j]->eval(points[k]);
+                EXPECT_EQ(h, IS_ONE(ans) || IS_LOG(ans));
+                EXPECT_EQ(l, IS_ZERO(ans) || IS_LOG(ans));
+            }
+        }
+    }
+}
+
+
+TEST_F(SimulateTest, Illogical)
+{
+    Array fs {
+        xs[0] | xs[1],
+        xs[0] & _ill,
+        ite(xs[0], xs[1], _ill),
+        impl(xs[0], xs[1]),
+        _log,
+    };
+    Tape tape(fs);
+
+    // x_0 is 1, X, 0, 1; x_1 is 1, 1, 1, illogical
+    vector<vector<uint64_t>> ones {{0xB}, {0x7}};
+    vector<vector<uint64_t>> zeros {{0x6}, {0x0}};
+    auto ys = tape.simulate_ternary(ones, zeros);
+
+    // Or: 1, 1, 1, illogical
+    EXPECT_EQ(ys.first[0][0], 0x7);
+    EXPECT_EQ(ys.second[0][0], 0x0);
+    // Illogical everywhere
+    EXPECT_EQ(ys.first[1][0], 0x0);
+    EXPECT_EQ(ys.second[1][0], 0x0);
+    EXPECT_EQ(ys.first[2][0], 0x0);
+    EXPECT_EQ(ys.second[2][0], 0x0);
+    // Implies: 1, 1, 1, illogical
+    EXPECT_EQ(ys.first[3][0], 0x7);
+    EXPECT_EQ(ys.second[3][0], 0x0);
+    // Logical everywhere
+    EXPECT_EQ(ys.first[4][0], ~uint64_t(0));
+    EXPECT_EQ(ys.second[4][0], ~uint64_t(0));
+}
@@ -0,0 +1,106 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class TapeTest : public BoolExprTest {};
+
+
+TEST_F(TapeTest, Basic)
+{
+    auto f = ~xs[2] | (xs[0] & ~xs[1]);
+    Tape tape(f);
+
+    EXPECT_EQ(tape.num_instrs(), 2);
+    EXPECT_EQ(tape.num_outputs(), 1);
+
+    // Inputs are sorted by id
+    vector<var_t> inputs {xs[0], xs[1], xs[2]};
+    EXPECT_EQ(tape.get_inputs(), inputs);
+
+    EXPECT_EQ(tape.eval({false, false, false})[0], _one);
+    EXPECT_EQ(tape.eval({true, false, true})[0], _one);
+    EXPECT_EQ(tape.eval({true, true, true})[0], _zero);
+
+    // Atoms compile to no instructions
+    Tape tape0(~xs[0]);
+    EXPECT_EQ(tape0.num_instrs(), 0);
+    EXPECT_EQ(tape0.eval({true})[0], _zero);
+
+    Tape tape1(_log);
+    EXPECT_EQ(tape1.eval(vector<bool>())[0], _log);
+
+    // Illogical takes precedence, as in simplify
+    Tape tape2(xs[0] & _ill);
+    EXPECT_EQ(tape2.eval({false})[0], _ill);
+
+    // Missing inputs are logical, and extra bits are ignored
+    EXPECT_EQ(tape.eval({false, true})[0], _log);
+    EXPECT_EQ(tape.eval({false, true, false, true})[0], _one);
+    auto yss = tape.eval_batch({{true, true, true}, {true}});
+    EXPECT_EQ(yss[0][0], _zero);
+    EXPECT_EQ(yss[1][0], _log);
+}
+
+
+// A tape agrees with eval at every point
+TEST_F(TapeTest, Eval)
+{
+    auto s = xs[0] ^ xs[1] ^ xs[2];
+    Array fs {
+        s,
+        nor({xs[0], ~xs[1], xs[2]}),
+        nand({xs[0], ~xs[1], s}),
+        xnor({xs[0], ~xs[1], xs[3]}),
+        neq({xs[0], ~xs[1], xs[2]}),
+        eq({xs[0], s, xs[3]}),
+        nimpl(xs[0], xs[1] | xs[2]),
+        impl(s, xs[1] | _log),
+        nite(xs[0], xs[1] ^ xs[2], ~xs[3]),
+        ite(xs[0] | _log, xs[1] ^ xs[2], ~xs[2]),
+        ite(_log, xs[3], xs[3]),
+    };
+
+    Tape tape(fs);
+    EXPECT_EQ(tape.num_outputs(), fs.size());
+
+    vector<var_t> vars {xs[0], xs[1], xs[2], xs[3]};
+    EXPECT_EQ(tape.get_inputs(), vars);
+
+    vector<vector<bool>> points;
+    for (auto it = points_iter(vars); it != points_iter(); ++it) {
+        vector<bool> bits;
+        for (auto const & x : vars) {
+            bits.push_back(IS_ONE((*it).find(x)->second));
+        }
+        points.push_back(bits);
+    }
+    auto yss = tape.eval_batch(points);
+
+    size_t i = 0;
+    for (auto it = points_iter(vars); it != points_iter(); ++it, ++i) {
+        auto ys = tape.eval(points[i]);
+        for (size_t j = 0; j < fs.size(); ++j) {
+            auto ans = fs[j]->restrict_(*it);
+            EXPECT_EQ(ys[j], ans);
+            EXPECT_EQ(yss[i][j], ans);
+        }
+    }
+}
@@ -0,0 +1,159 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class TruthTableTest : public BoolExprTest {};
+
+
+TEST_F(TruthTableTest, Basic)
+{
+    auto f = xs[0] & ~xs[1];
+    auto t = *truth_table(f);
+
+    vector<var_t> vars {xs[0], xs[1]};
+    EXPECT_EQ(t.get_vars(), vars);
+    // 0b0010, repeated
+    EXPECT_EQ(t.get_words()[0], 0x2222222222222222ULL);
+    EXPECT_EQ(t.count(), 1);
+
+    EXPECT_TRUE(truth_table(_zero)->is_zero());
+    EXPECT_TRUE(truth_table(_one)->is_one());
+    EXPECT_EQ(truth_table(_one)->count(), 1);
+
+    // Unknowns don't fit in a truth table
+    EXPECT_FALSE(truth_table(xs[0] | _log));
+    EXPECT_FALSE(truth_table(_ill));
+
+    // The variables must cover the support
+    EXPECT_FALSE(truth_table(f, vector<var_t> {xs[0]}));
+    EXPECT_FALSE(truth_table(f, vector<var_t> {xs[1], xs[2]}));
+    EXPECT_EQ(truth_table(f, vector<var_t> {xs[0], xs[1], xs[2]})->count(), 2);
+
+    // Too many variables
+    vector<bx_t> args(xs.begin(), xs.begin() + 17);
+    EXPECT_FALSE(truth_table(xor_(args)));
+    args.pop_back();
+    EXPECT_EQ(truth_table(xor_(args))->count(), 1 << 15);
+}
+
+
+// Agrees with eval at every point, in one word and in many
+TEST_F(TruthTableTest, Eval)
+{
+    auto f = (xs[0] ^ xs[3]) | ite(xs[2], ~xs[1], xs[4] & xs[5]);
+    auto g = eq({f, xs[6], xs[9]}) | impl(xs[7], xs[8]);
+
+    for (auto const & y : {f, g}) {
+        auto t = *truth_table(y);
+        auto const & vars = t.get_vars();
+        auto const & words = t.get_words();
+        uint64_t count = 0;
+
+        size_t k = 0;
+        for (auto it = points_iter(vars); it != points_iter(); ++it) {
+            // points_iter counts with vars[0] as the high bit
+            size_t m = 0;
+            for (size_t i = 0; i < vars.size(); ++i) {
+                m |= size_t(IS_ONE((*it).find(vars[i])->second)) << i;
+            }
+            bool bit = (words[m / 64] >> (m % 64)) & 1;
+            auto ans = y->eval(*it);
+            EXPECT_EQ(bit, IS_ONE(ans));
+            count += bit;
+            ++k;
+        }
+        EXPECT_EQ(k, size_t(1) << vars.size());
+        EXPECT_EQ(t.count(), count);
+
+        // Round trip
+        EXPECT_TRUE(truth_table(t.to_bx(), vars)->equiv(t));
+    }
+}
+
+
+TEST_F(TruthTableTest, Ops)
+{
+    auto f = (xs[0] & xs[1]) | (xs[7] ^ xs[2]);
+    auto g = ite(xs[7], xs[0], ~xs[2]) | xs[1];
+    vector<var_t> vars {xs[0], xs[1], xs[2], xs[7]};
+
+    auto tf = *truth_table(f, vars);
+    auto tg = *truth_table(g, vars);
+
+    EXPECT_TRUE((~tf).equiv(*truth_table(~f, vars)));
+    EXPECT_TRUE((tf | tg).equiv(*truth_table(f | g, vars)));
+    EXPECT_TRUE((tf & tg).equiv(*truth_table(f & g, vars)));
+    EXPECT_TRUE((tf ^ tg).equiv(*truth_table(f ^ g, vars)));
+
+    for (auto const & x : vars) {
+        point_t p0 {{x, _zero}};
+        point_t p1 {{x, _one}};
+        EXPECT_TRUE(tf.cofactor(x, false).equiv(
+            *truth_table(f->restrict_(p0), vars)));
+        EXPECT_TRUE(tf.cofactor(x, true).equiv(
+            *truth_table(f->restrict_(p1), vars)));
+    }
+
+    auto soln = tf.sat();
+    EXPECT_TRUE(soln.first);
+    EXPECT_EQ(f->restrict_(*soln.second), _one);
+    EXPECT_FALSE((tf & ~tf).sat().first);
+}
+
+
+// Quantifiers agree with cofactors, in one word and across words
+TEST_F(TruthTableTest, Quantify)
+{
+    auto f = (xs[0] & xs[8]) | (xs[1] ^ xs[9]) | (xs[2] & ~xs[3]);
+    auto t = *truth_table(f);
+
+    for (auto const & ys : vector<vector<var_t>> {{xs[0]}, {xs[9]},
+                                                  {xs[1], xs[8]}}) {
+        vector<bx_t> cfs(cf_iter(f, ys), cf_iter());
+        auto vars = t.get_vars();
+        EXPECT_TRUE(t.smoothing(ys).equiv(*truth_table(or_(cfs), vars)));
+        EXPECT_TRUE(t.consensus(ys).equiv(*truth_table(and_(cfs), vars)));
+        EXPECT_TRUE(t.derivative(ys).equiv(*truth_table(xor_(cfs), vars)));
+    }
+
+    // Outside the support
+    EXPECT_TRUE(t.smoothing({xs[5]}).equiv(t));
+    EXPECT_TRUE(t.derivative({xs[5]}).is_zero());
+}
+
+
+// BoolExpr methods use truth tables for small functions
+TEST_F(TruthTableTest, Auto)
+{
+    auto f = (xs[0] & xs[1]) | (~xs[0] & xs[2]);
+    auto g = ite(xs[0], xs[1], xs[2]);
+    EXPECT_TRUE(f->equiv(g));
+    EXPECT_FALSE(f->equiv(g | xs[3]));
+
+    EXPECT_TRUE(f->smoothing({xs[0]})->equiv(xs[1] | xs[2]));
+    EXPECT_TRUE(f->consensus({xs[0]})->equiv(xs[1] & xs[2]));
+    EXPECT_TRUE(f->derivative({xs[0]})->equiv(xs[1] ^ xs[2]));
+
+    auto soln = (f & ~xs[1])->sat();
+    EXPECT_TRUE(soln.first);
+    EXPECT_EQ((f & ~xs[1])->restrict_(*soln.second), _one);
+    EXPECT_FALSE((f & ~g)->sat().first);
+}
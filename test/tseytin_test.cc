@@ -24,7 +24,7 @@ class TseytinTest : public BoolExprTest {};
 
 TEST_F(TseytinTest, Atoms)
 {
-    auto ctx = Context();
+    Context ctx;
 
     EXPECT_EQ(_zero->tseytin(ctx), _zero);
     EXPECT_EQ(_one->tseytin(ctx), _one);
@@ -38,7 +38,7 @@ TEST_F(TseytinTest, Atoms)
 
 TEST_F(TseytinTest, Operators)
 {
-    auto ctx = Context();
+    Context ctx;
 
     auto y0 =  nor_s({xs[0],  xor_s({xs[1], xs[2]}), xs[3]});
     auto y1 =   or_s({xs[0], xnor_s({xs[1], xs[2]}), xs[3]});
@@ -72,7 +72,7 @@ TEST_F(TseytinTest, Operators)
 
 TEST_F(TseytinTest, CNF)
 {
-    auto ctx = Context();
+    Context ctx;
 
     auto y0 = onehot({xs[0], xs[1], xs[2], xs[3]});
     auto y1 = y0->tseytin(ctx);
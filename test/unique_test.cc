@@ -0,0 +1,124 @@
+// Copyright 2016 Chris Drake
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "boolexpr/boolexpr.h"
+#include "boolexprtest.h"
+
+
+class UniqueTest : public BoolExprTest {};
+
+
+TEST_F(UniqueTest, Disabled)
+{
+    auto prev = enable_unique_table(false);
+
+    auto y0 = xs[0] | xs[1];
+    auto y1 = xs[0] | xs[1];
+    EXPECT_NE(y0, y1);
+
+    enable_unique_table(prev);
+}
+
+
+TEST_F(UniqueTest, Enabled)
+{
+    auto prev = enable_unique_table(true);
+    EXPECT_TRUE(unique_table_enabled());
+
+    auto y0 = xs[0] | xs[1];
+    auto y1 = xs[0] | xs[1];
+    EXPECT_EQ(y0, y1);
+
+    // Argument order matters
+    auto y2 = xs[1] | xs[0];
+    EXPECT_NE(y0, y2);
+
+    // Kind matters
+    auto y3 = xs[0] & xs[1];
+    EXPECT_NE(y0, y3);
+
+    auto y4 = ite(xs[0], y0, y3);
+    auto y5 = ite(xs[0], xs[0] | xs[1], xs[0] & xs[1]);
+    EXPECT_EQ(y4, y5);
+
+    auto y6 = ~y4;
+    auto y7 = ~y5;
+    EXPECT_EQ(y6, y7);
+
+    auto y8 = xor_({xs[0], xs[1], xs[2]})->simplify();
+    auto y9 = xor_({xs[0], xs[1], xs[2]})->simplify();
+    EXPECT_EQ(y8, y9);
+
+    enable_unique_table(prev);
+}
+
+
+TEST_F(UniqueTest, Release)
+{
+    auto prev = enable_unique_table(true);
+
+    auto n = unique_table_size();
+    {
+        auto y0 = impl(xs[0], xs[1]);
+        auto y1 = impl(xs[0], xs[1]);
+        EXPECT_EQ(y0, y1);
+        EXPECT_EQ(unique_table_size(), n + 1);
+    }
+    EXPECT_EQ(unique_table_size(), n);
+
+    enable_unique_table(prev);
+}
+
+
+TEST_F(UniqueTest, CanonicalOrder)
+{
+    auto prev_table = enable_unique_table(true);
+    auto prev_order = enable_canonical_order(true);
+    EXPECT_TRUE(canonical_order_enabled());
+
+    auto y0 = xs[0] | xs[1];
+    auto y1 = xs[1] | xs[0];
+    EXPECT_EQ(y0, y1);
+
+    auto y2 = eq({xs[2], ~xs[1], xs[0]});
+    auto y3 = eq({~xs[1], xs[0], xs[2]});
+    EXPECT_EQ(y2, y3);
+
+    // Argument order still matters for non-commutative operators
+    auto y4 = impl(xs[0], xs[1]);
+    auto y5 = impl(xs[1], xs[0]);
+    EXPECT_NE(y4, y5);
+
+    // The order does not depend on when the arguments were made.
+    // Make the variables in the same order as the fixture, so the ids match.
+    Context other;
+    for (auto name : {"p", "q", "s", "d1", "d0"}) {
+        other.get_var(name);
+    }
+    auto zs = vector<var_t> {
+        other.get_var("x_0"), other.get_var("x_1"),
+        other.get_var("x_2"), other.get_var("x_3"),
+    };
+    auto z1 = zs[2] & zs[3];
+    auto z0 = zs[0] & zs[1];
+    auto y6 = (xs[0] & xs[1]) | (xs[2] & xs[3]);
+    EXPECT_EQ((z0 | z1)->to_string(), y6->to_string());
+    EXPECT_EQ((z1 | z0)->to_string(), y6->to_string());
+
+    enable_canonical_order(prev_order);
+    enable_unique_table(prev_table);
+}
@@ -36,6 +36,28 @@ class ContextTest(unittest.TestCase):
         ctx = Context()
         del ctx
 
+    def test_get_vars(self):
+        """Context get_vars method"""
+        ctx = Context()
+        xs = ctx.get_vars("x", (1, 3), 4)
+        self.assertEqual(xs.shape, ((1, 3), (0, 4)))
+        self.assertEqual(xs.size, 2*4)
+        for i in range(1, 3):
+            for j in range(4):
+                x = xs[i,j]
+                name = "x[{},{}]".format(i, j)
+                self.assertEqual(str(x), name)
+                self.assertIs(x, ctx.get_var(name))
+
+        # The same block again is the same variables
+        ys = ctx.get_vars("x", (1, 3), 4)
+        self.assertIs(ys[2,3], xs[2,3])
+
+        # One-dimensional
+        zs = ctx.get_vars("z", 3)
+        self.assertEqual(str(zs), "array([z[0], z[1], z[2]])")
+        self.assertIs(zs[2], ctx.get_var("z[2]"))
+
 
 class BoolExprTest(unittest.TestCase):
 